@@ -1,25 +1,57 @@
 #include "QtFakeTime.h"
+#include "QtFakeTimeSchedule.h"
 
 // TODO: Extensive comments
 
 
 #include <QDebug>
 #include <QtGlobal>
-#include <QProcessEnvironment>
 
 #include <QDateTime>
+#include <QTimeZone>
 #include <QElapsedTimer>
+#include <QDeadlineTimer>
 #include <QTimer>
 #include <QCoreApplication>
 #include <QThread>
 #include <QMutex>
+#include <QReadWriteLock>
+#include <QWaitCondition>
+#include <QSemaphore>
+#include <QThreadPool>
+#include <QProcess>
+#include <QEvent>
+#include <QAbstractEventDispatcher>
+#include <QRegExp>
+#include <QFile>
 
 #include <dlfcn.h>
-
-#include <map>
-#include <algorithm>
+#include <link.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/select.h>
+#include <string.h>
+#include <time.h>
+#include <sys/time.h>
+
+#include <deque>
+#include <set>
+#include <unordered_map>
+#include <vector>
 #include <memory>
+#include <limits>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <chrono>
+#include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <cstdio>
+#include <string>
 
 #ifndef __linux__
     #error "Library is dependant on LD_PRELOAD linker support in order to shim libQt5Core function implementations (a linux specific feature)"
@@ -30,804 +62,5059 @@ using namespace QtFakeTime;
 
 //------------------------------------------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------------------------------------------
-// Function pointers indicating the original versions of the libQt5Core.so functions we are shimming.  Only populated
-// where we actually need to access the underlying real behaviour from libQt5Core.
+// Table of the original versions of the libQt5Core.so (and libc) functions we are shimming, where we actually need to access the
+// underlying real behaviour.
+//
+// Each is looked up on first use via. dlsym(RTLD_NEXT), i.e. the next definition after our own in whichever libQt5Core.so.5/libc the
+// process is linked against, so processes only pay for the functions they actually reach.  Lookups being constant initialised, they
+// can be used before initialize() has run (other libraries' constructors may well read the clock first).
+
+template<typename Function>
+class RealFunction
+{
+public:
+    constexpr RealFunction(const char* symbol, const char* description)
+        : symbol(symbol), description(description), address(nullptr) {}
+
+    // Called via. conversion to the real function pointer
+    operator Function() const
+    {
+        Function function = address.load(std::memory_order_relaxed);
+
+        return (function != nullptr) ? function : bind();
+    }
+
+private:
+    Function bind(void) const
+    {
+        Function function;
+
+        *(void **) (&function) = dlsym(RTLD_NEXT, symbol);
+
+        if (function == nullptr)
+        {
+            qFatal("Couldn't locate symbol associated with %s", description);
+        }
+
+        address.store(function, std::memory_order_relaxed);
+
+        return function;
+    }
+
+    const char*                     symbol;
+    const char*                     description;
+    mutable std::atomic<Function>   address;
+};
 
 //------------------------------------------------------------------------------------------------------------------------
 // QDateTime methods
-static QDateTime (* pQt5Core_QDateTime_currentDateTime)(void) = nullptr;
-static QDateTime (* pQt5Core_QDateTime_currentDateTimeUtc)(void) = nullptr;
-static qint64 (* pQt5Core_QDateTime_currentMSecsSinceEpoch)(void) = nullptr;
-static qint64 (* pQt5Core_QDateTime_currentSecsSinceEpoch)(void) = nullptr;
+static RealFunction<QDateTime (*)(void)> pQt5Core_QDateTime_currentDateTime{"_ZN9QDateTime15currentDateTimeEv", "QDateTime::currentDateTime() method in libQt5Core.so"};
+static RealFunction<QDateTime (*)(void)> pQt5Core_QDateTime_currentDateTimeUtc{"_ZN9QDateTime18currentDateTimeUtcEv", "QDateTime::currentDateTimeUtc() method in libQt5Core.so"};
+static RealFunction<qint64 (*)(void)> pQt5Core_QDateTime_currentMSecsSinceEpoch{"_ZN9QDateTime22currentMSecsSinceEpochEv", "QDateTime::currentMSecsSinceEpoch() method in libQt5Core.so"};
+static RealFunction<qint64 (*)(void)> pQt5Core_QDateTime_currentSecsSinceEpoch{"_ZN9QDateTime21currentSecsSinceEpochEv", "QDateTime::currentSecsSinceEpoch() method in libQt5Core.so"};
 
 //------------------------------------------------------------------------------------------------------------------------
 // QTimer methods
 
-static void (* pQt5Core_QTimer_setInterval)(QTimer*, int) = nullptr;
-static void (* pQt5Core_QTimer_start)(QTimer*) = nullptr;
-static void (* pQt5Core_QTimer_singleShotImpl)(int, Qt::TimerType, const QObject*, QtPrivate::QSlotObjectBase *) = nullptr;
+static RealFunction<void (*)(QTimer*, int)> pQt5Core_QTimer_setInterval{"_ZN6QTimer11setIntervalEi", "QTimer::setInterval() method in libQt5Core.so"};
+static RealFunction<void (*)(QTimer*)> pQt5Core_QTimer_start{"_ZN6QTimer5startEv", "QTimer::start() method in libQt5Core.so"};
+static RealFunction<void (*)(QTimer*)> pQt5Core_QTimer_stop{"_ZN6QTimer4stopEv", "QTimer::stop() method in libQt5Core.so"};
+static RealFunction<void (*)(int, Qt::TimerType, const QObject*, QtPrivate::QSlotObjectBase *)> pQt5Core_QTimer_singleShotImpl{"_ZN6QTimer14singleShotImplEiN2Qt9TimerTypeEPK7QObjectPN9QtPrivate15QSlotObjectBaseE", "QTimer::singleShotImpl() method in libQt5Core.so"};
 
 //------------------------------------------------------------------------------------------------------------------------
+// QThread methods
 
-static qint64 fakedMSSinceEpoch = -1;
+static RealFunction<void (*)(unsigned long)> pQt5Core_QThread_sleep{"_ZN7QThread5sleepEm", "QThread::sleep() method in libQt5Core.so"};
+static RealFunction<void (*)(unsigned long)> pQt5Core_QThread_msleep{"_ZN7QThread6msleepEm", "QThread::msleep() method in libQt5Core.so"};
+static RealFunction<void (*)(unsigned long)> pQt5Core_QThread_usleep{"_ZN7QThread6usleepEm", "QThread::usleep() method in libQt5Core.so"};
+static RealFunction<bool (*)(QThread*, unsigned long)> pQt5Core_QThread_wait{"_ZN7QThread4waitEm", "QThread::wait() method in libQt5Core.so"};
 
-// These are declared external to setupIdleTimer() function so they can be reset from sanitiseTimers();
-static qint64 fakedTimeAtLastIdleTimerTick   = -1;
-static qint64 realTimeAtLastIdleTimerTick    = -1;
+//------------------------------------------------------------------------------------------------------------------------
+// Synchronisation primitive methods
 
-// Map associating active QElapsedTimers and their start times
-//
-// NOTE: QElapsedTimer doesn't have a destructor we can shim in order to clean up <qElapsedTimerStartTimes>, so the map is
-// potentially going to fill up with stale pointers.  This infers that it is NOT safe to reference a QElapsedTimer instance
-// from the pointer reference stored in the map.
-static std::map<QElapsedTimer*, qint64> qElapsedTimerStartTimes;
+static RealFunction<bool (*)(QWaitCondition*, QMutex*, unsigned long)> pQt5Core_QWaitCondition_wait{"_ZN14QWaitCondition4waitEP6QMutexm", "QWaitCondition::wait() method in libQt5Core.so"};
+static RealFunction<void (*)(QWaitCondition*)> pQt5Core_QWaitCondition_wakeOne{"_ZN14QWaitCondition7wakeOneEv", "QWaitCondition::wakeOne() method in libQt5Core.so"};
+static RealFunction<void (*)(QWaitCondition*)> pQt5Core_QWaitCondition_wakeAll{"_ZN14QWaitCondition7wakeAllEv", "QWaitCondition::wakeAll() method in libQt5Core.so"};
+static RealFunction<bool (*)(QSemaphore*, int, int)> pQt5Core_QSemaphore_tryAcquire{"_ZN10QSemaphore10tryAcquireEii", "QSemaphore::tryAcquire() method in libQt5Core.so"};
+static RealFunction<bool (*)(QMutex*, int)> pQt5Core_QMutex_tryLock{"_ZN6QMutex7tryLockEi", "QMutex::tryLock() method in libQt5Core.so"};
+static RealFunction<bool (*)(QThreadPool*, int)> pQt5Core_QThreadPool_waitForDone{"_ZN11QThreadPool11waitForDoneEi", "QThreadPool::waitForDone() method in libQt5Core.so"};
 
-// Map associating active QTimers and their end times, with entries cleaned up at point timer stops or is destroyed.
-static std::map<QTimer*, qint64> qTimerDueTimes;
+//------------------------------------------------------------------------------------------------------------------------
+// QProcess methods
+
+static RealFunction<bool (*)(QProcess*, int)> pQt5Core_QProcess_waitForStarted{"_ZN8QProcess14waitForStartedEi", "QProcess::waitForStarted() method in libQt5Core.so"};
+static RealFunction<bool (*)(QProcess*, int)> pQt5Core_QProcess_waitForReadyRead{"_ZN8QProcess16waitForReadyReadEi", "QProcess::waitForReadyRead() method in libQt5Core.so"};
+static RealFunction<bool (*)(QProcess*, int)> pQt5Core_QProcess_waitForBytesWritten{"_ZN8QProcess19waitForBytesWrittenEi", "QProcess::waitForBytesWritten() method in libQt5Core.so"};
+static RealFunction<bool (*)(QProcess*, int)> pQt5Core_QProcess_waitForFinished{"_ZN8QProcess15waitForFinishedEi", "QProcess::waitForFinished() method in libQt5Core.so"};
 
 //------------------------------------------------------------------------------------------------------------------------
+// QtNetwork socket & server methods.  libQt5Network.so is only loaded by applications that use it, shims needing these being
+// unreachable until it is.
+
+static RealFunction<qintptr (*)(const QIODevice*)> pQt5Network_QAbstractSocket_socketDescriptor{"_ZNK15QAbstractSocket16socketDescriptorEv", "QAbstractSocket::socketDescriptor() method in libQt5Network.so"};
+static RealFunction<int (*)(const QIODevice*)> pQt5Network_QAbstractSocket_state{"_ZNK15QAbstractSocket5stateEv", "QAbstractSocket::state() method in libQt5Network.so"};
+static RealFunction<bool (*)(QIODevice*, int)> pQt5Network_QAbstractSocket_waitForConnected{"_ZN15QAbstractSocket16waitForConnectedEi", "QAbstractSocket::waitForConnected() method in libQt5Network.so"};
+static RealFunction<bool (*)(QIODevice*, int)> pQt5Network_QAbstractSocket_waitForReadyRead{"_ZN15QAbstractSocket16waitForReadyReadEi", "QAbstractSocket::waitForReadyRead() method in libQt5Network.so"};
+static RealFunction<bool (*)(QIODevice*, int)> pQt5Network_QAbstractSocket_waitForBytesWritten{"_ZN15QAbstractSocket19waitForBytesWrittenEi", "QAbstractSocket::waitForBytesWritten() method in libQt5Network.so"};
+static RealFunction<bool (*)(QIODevice*, int)> pQt5Network_QAbstractSocket_waitForDisconnected{"_ZN15QAbstractSocket19waitForDisconnectedEi", "QAbstractSocket::waitForDisconnected() method in libQt5Network.so"};
+
+static RealFunction<qintptr (*)(const QIODevice*)> pQt5Network_QLocalSocket_socketDescriptor{"_ZNK12QLocalSocket16socketDescriptorEv", "QLocalSocket::socketDescriptor() method in libQt5Network.so"};
+static RealFunction<int (*)(const QIODevice*)> pQt5Network_QLocalSocket_state{"_ZNK12QLocalSocket5stateEv", "QLocalSocket::state() method in libQt5Network.so"};
+static RealFunction<bool (*)(QIODevice*, int)> pQt5Network_QLocalSocket_waitForConnected{"_ZN12QLocalSocket16waitForConnectedEi", "QLocalSocket::waitForConnected() method in libQt5Network.so"};
+static RealFunction<bool (*)(QIODevice*, int)> pQt5Network_QLocalSocket_waitForReadyRead{"_ZN12QLocalSocket16waitForReadyReadEi", "QLocalSocket::waitForReadyRead() method in libQt5Network.so"};
+static RealFunction<bool (*)(QIODevice*, int)> pQt5Network_QLocalSocket_waitForBytesWritten{"_ZN12QLocalSocket19waitForBytesWrittenEi", "QLocalSocket::waitForBytesWritten() method in libQt5Network.so"};
+static RealFunction<bool (*)(QIODevice*, int)> pQt5Network_QLocalSocket_waitForDisconnected{"_ZN12QLocalSocket19waitForDisconnectedEi", "QLocalSocket::waitForDisconnected() method in libQt5Network.so"};
+
+static RealFunction<bool (*)(QObject*, int, bool*)> pQt5Network_QTcpServer_waitForNewConnection{"_ZN10QTcpServer20waitForNewConnectionEiPb", "QTcpServer::waitForNewConnection() method in libQt5Network.so"};
+static RealFunction<bool (*)(QObject*, int, bool*)> pQt5Network_QLocalServer_waitForNewConnection{"_ZN12QLocalServer20waitForNewConnectionEiPb", "QLocalServer::waitForNewConnection() method in libQt5Network.so"};
+
 //------------------------------------------------------------------------------------------------------------------------
-// Shim functions faking selected Qt5Core library functionality.
+// libc clock, sleep & wait functions
+
+static RealFunction<int (*)(clockid_t, struct timespec*)> pLibc_clock_gettime{"clock_gettime", "clock_gettime() in libc"};
+static RealFunction<int (*)(struct timeval*, void*)> pLibc_gettimeofday{"gettimeofday", "gettimeofday() in libc"};
+static RealFunction<time_t (*)(time_t*)> pLibc_time{"time", "time() in libc"};
+static RealFunction<int (*)(const struct timespec*, struct timespec*)> pLibc_nanosleep{"nanosleep", "nanosleep() in libc"};
+static RealFunction<int (*)(clockid_t, int, const struct timespec*, struct timespec*)> pLibc_clock_nanosleep{"clock_nanosleep", "clock_nanosleep() in libc"};
+static RealFunction<int (*)(useconds_t)> pLibc_usleep{"usleep", "usleep() in libc"};
+static RealFunction<unsigned int (*)(unsigned int)> pLibc_sleep{"sleep", "sleep() in libc"};
+static RealFunction<int (*)(struct pollfd*, nfds_t, int)> pLibc_poll{"poll", "poll() in libc"};
+static RealFunction<int (*)(int, struct epoll_event*, int, int)> pLibc_epoll_wait{"epoll_wait", "epoll_wait() in libc"};
+static RealFunction<int (*)(int, fd_set*, fd_set*, fd_set*, struct timeval*)> pLibc_select{"select", "select() in libc"};
+static RealFunction<int (*)(pthread_cond_t*, pthread_mutex_t*, const struct timespec*)> pLibc_pthread_cond_timedwait{"pthread_cond_timedwait", "pthread_cond_timedwait() in libc"};
+static RealFunction<int (*)(pthread_cond_t*, pthread_mutex_t*, clockid_t, const struct timespec*)> pLibc_pthread_cond_clockwait{"pthread_cond_clockwait", "pthread_cond_clockwait() in libc"};
 
-//-----------------------------------------------------------------------------------------------------------------------
-// QDateTime method shims
+//------------------------------------------------------------------------------------------------------------------------
 
-inline static QDateTime QDateTime_currentDateTime_shim(void)
-{
-    if (fakedMSSinceEpoch == -1)
-    {
-        // Return real value from underlying Qt Core library
-        assert(pQt5Core_QDateTime_currentDateTime != nullptr);
-        return pQt5Core_QDateTime_currentDateTime();
-    }
-    else
-    {
-        return QDateTime::fromMSecsSinceEpoch(fakedMSSinceEpoch);
-    }
-}
+static constexpr qint64 nsPerMS = 1000000;
 
-inline static QDateTime QDateTime_currentDateTimeUtc_shim(void)
+// Number of most recent set()/reset() calls remembered by each domain for lazily restarting QElapsedTimers (see TimeDomain::timeJumps)
+static constexpr size_t timeJumpHistory = 256;
+
+// Fire all timers due at the same time before processing events, rather than processing events after every timeout
+static std::atomic<bool> batchedTimeouts(false);
+
+// Real time a thread is given to pick up a batch of timeouts posted to it, before the batch is reclaimed & generated by the thread
+// waiting on it instead (see waitForTimeoutBatches())
+static constexpr qint64 batchPickupTimeoutNS = 100 * nsPerMS;
+
+// Real time a thread may spend generating a batch of timeouts before it's taken to be stalled on a blocking queued call into the thread
+// waiting on it
+static constexpr qint64 batchStallTimeoutNS = 10 * nsPerMS;
+
+// Barrier at which the thread generating timeouts due at a particular faked time waits for other threads to finish generating
+// timeouts for their own timers due at that time.
+struct TickBarrier
 {
-    if (fakedMSSinceEpoch == -1)
-    {
-        // Return real value from underlying Qt Core library
-        assert(pQt5Core_QDateTime_currentDateTimeUtc != nullptr);
-        return pQt5Core_QDateTime_currentDateTimeUtc();
-    }
-    else
-    {
-        return QDateTime::fromMSecsSinceEpoch(fakedMSSinceEpoch, Qt::UTC);
-    }
-}
+    QMutex mutex;
+    QWaitCondition allArrived;
+    int outstanding = 0;
 
-inline static qint64 QDateTime_currentMSecsSinceEpoch_shim(void)
+    void arrive(void);
+};
+
+struct TimerShard;
+
+// Batch of a thread's timeouts due at <timeDue>, generated by whichever of the thread itself or the thread waiting on <barrier> claims
+// it first.  Shared with the TimeoutBatchEvent carrying it, as an undelivered event can outlive the wait.
+struct TimeoutBatch
 {
-    if (fakedMSSinceEpoch == -1)
-    {
-        // Return real value from underlying Qt Core library
-        assert(pQt5Core_QDateTime_currentMSecsSinceEpoch != nullptr);
-        return pQt5Core_QDateTime_currentMSecsSinceEpoch();
-    }
-    else
-    {
-        return fakedMSSinceEpoch;
-    }
-}
+    std::shared_ptr<TimerShard> shard;
+    qint64 timeDue;
+    qint64 limit;
+    bool processEvents;
+    std::shared_ptr<TickBarrier> barrier;
 
-inline static qint64 QDateTime_currentSecsSinceEpoch_shim(void)
+    std::atomic<bool> claimed{false};
+    std::atomic<qint64> startedNS{0};       // Real time owning thread started generating batch, 0 until then
+    std::atomic<bool> finished{false};
+
+    bool claim(void);
+};
+
+// Posted to a thread's TimerDispatcher to have it generate a batch of timeouts.  Claims the batch on destruction should the event be
+// discarded unprocessed, so that the barrier is still released.
+class TimeoutBatchEvent: public QEvent
 {
-    if (fakedMSSinceEpoch == -1)
+public:
+    explicit TimeoutBatchEvent(const std::shared_ptr<TimeoutBatch>& batch)
+        : QEvent(eventType()), batch(batch) {}
+
+    ~TimeoutBatchEvent() override
     {
-        // Return real value from underlying Qt Core library
-        assert(pQt5Core_QDateTime_currentSecsSinceEpoch != nullptr);
-        return pQt5Core_QDateTime_currentSecsSinceEpoch();
+        if (batch->claim())
+        {
+            batch->barrier->arrive();
+        }
     }
-    else
+
+    static QEvent::Type eventType(void)
     {
-        return fakedMSSinceEpoch / 1000;
+        static const QEvent::Type type = static_cast<QEvent::Type>(QEvent::registerEventType());
+        return type;
     }
-}
 
-//------------------------------------------------------------------------------------------------------------------------
-// QTime method shims
+    const std::shared_ptr<TimeoutBatch> batch;
+};
 
-inline static QTime QTime_currentTime_shim(void)
+// Lives in thread owning a shard's timers, generating timeouts for them on receipt of TimeoutBatchEvent.
+class TimerDispatcher: public QObject
 {
-    // Unconditionally return QTime component of possibily faked QDateTime::currentDateTime()
-    return QDateTime::currentDateTime().time();
-}
+public:
+    explicit TimerDispatcher(TimerShard& shard)
+        : shard(shard) {}
 
-//------------------------------------------------------------------------------------------------------------------------
-// QElapsedTimer method shims.
+    bool event(QEvent* event) override;
 
-inline static bool QElapsedTimer_isValid_shim(QElapsedTimer* timer)
-{
-    return qElapsedTimerStartTimes.find(timer) != qElapsedTimerStartTimes.end();
-}
+private:
+    TimerShard& shard;
+};
 
-inline static qint64 QElapsedTimer_elapsed_shim(QElapsedTimer* timer)
+// Active QTimers are tracked per owning thread, each thread's timers held in a shard of their own with its own lock, so threads
+// starting/stopping their own timers don't contend with one another.
+//
+// NOTE: Timers are expected to be stopped before being moved to another thread, as an active timer remains in the shard of the thread
+// it was started from.
+struct TimerShard: public std::enable_shared_from_this<TimerShard>
 {
-    // Qt documentation for "real" QElapsedTimer describes unspecified behaviour when calling elapsed(), hasExpired() etc
-    // on invalid timer.
+    TimeDomain* domain;
+    QThread* thread;
+    QMutex mutex;
 
-    assert(qElapsedTimerStartTimes.find(timer) != qElapsedTimerStartTimes.end());
+    // Set by <thread> itself as it exits (see timerShard()), so other threads needn't go near a QThread that may be mid-destruction
+    std::atomic<bool> finished{false};
 
-    return QDateTime::currentMSecsSinceEpoch() - qElapsedTimerStartTimes.at(timer);
-}
+    // Created on first need to generate timeouts for timers from a thread other than <thread>
+    std::unique_ptr<TimerDispatcher> dispatcher;
 
-inline static bool _ZNK13QElapsedTimer_hasExpired_shim(QElapsedTimer* timer, qint64 timeout)
-{
-    return timer->elapsed() >= timeout;
-}
+    // Set while <thread> is parked in a faked sleep or wait, holding back its timers until it wakes (as they would be were it really
+    // asleep)
+    std::atomic<bool> parked{false};
 
-inline static void QElapsedTimer_invalidate_shim(QElapsedTimer* timer)
-{
-    qElapsedTimerStartTimes.erase(timer);
-}
+    // Batches of timeouts posted to <dispatcher> but yet to be claimed
+    std::atomic<int> pendingBatches{0};
 
-inline static void QElapsedTimer_start_shim(QElapsedTimer* timer)
-{
-    qElapsedTimerStartTimes[timer] = QDateTime::currentMSecsSinceEpoch();
-}
+    // Set once a batch posted to <dispatcher> has had to be reclaimed, with timeouts generated from other threads instead until <thread>
+    // catches up with its events
+    std::atomic<bool> unresponsive{false};
 
-inline static qint64 QElapsedTimer_restart_shim(QElapsedTimer* timer)
-{
-    qint64 elapsed = timer->elapsed();
+    // Schedule of active QTimers and their end times, with entries cleaned up at point timer stops or is destroyed.  Implementation
+    // selectable via. setTimerStore().
+    std::unique_ptr<TimerSchedule> schedule;
 
-    timer->start();
+    // Whether <schedule> holds any timers, updated under <mutex> on every change, so scans for due timers can pass over shards with
+    // nothing scheduled without taking their lock
+    std::atomic<bool> hasTimers{false};
 
-    return elapsed;
-}
+    void scheduleChanged(void)
+    {
+        hasTimers = !schedule->empty();
+    }
 
-inline static qint64 QElapsedTimer_secsTo_shim(QElapsedTimer* timer, const QElapsedTimer&)
-{
-    // Not currently supported
-    assert(false);
-    return -1;
-}
+    // Ticks skipped by skip-ahead timers since their last timeout
+    std::unordered_map<const QTimer*, uint64_t> skippedTicks;
+};
 
-inline static qint64 QElapsedTimer_msecsSinceReference_shim(QElapsedTimer* timer)
+// Independent faked clock, along with the timers of threads bound to it.  Threads not explicitly bound to a domain share the default
+// domain.
+class QtFakeTime::TimeDomain
 {
-    // Not currently supported
-    assert(false);
-    return -1;
-}
+public:
+    // Faked current time (nS since epoch), or -1 if not currently faking.  Atomic so that shims can read the clock from any thread
+    // without locking, only ever written with <clockControlMutex> held.
+    std::atomic<qint64> fakedNSSinceEpoch{-1};
+
+    // Faked monotonic clock (nS) seen by QDeadlineTimer, or -1 if not currently faking.  Steps forward along with faked time on
+    // fastForward(), but unlike faked time isn't moved by set()/reset().  While not faking, domain's monotonic clock runs
+    // <monotonicLeadNS> ahead of the real monotonic clock, so it never goes backwards on reset().
+    std::atomic<qint64> fakedMonotonicNS{-1};
+    std::atomic<qint64> monotonicLeadNS{0};
+
+    // Threads blocked in a faked sleep or wait (see virtualWait()), woken whenever faked time moves.  Each blocked thread's wake time
+    // (on domain's monotonic clock) is held in <wakeTimes>, with <participants> counting threads that have blocked in domain since its
+    // participation was last reset (<participationGeneration> incremented every time it is) and are yet to exit, and <blockedGeneration>
+    // incremented every time a thread blocks or unblocks.  Guarded by <sleepersMutex>.
+    // Waited on via. the real QWaitCondition::wait(), as it times out on the real clock whether or not libc clocks are being faked.
+    QMutex sleepersMutex;
+    QWaitCondition timeMoved;
+    std::atomic<int> sleepers{0};
+    std::multiset<qint64> wakeTimes;
+    int participants = 0;
+    quint64 participationGeneration = 0;
+    quint64 blockedGeneration = 0;
+
+    // Whether faked time moves on by itself once all participating threads are blocked, and whether a blocked thread is currently
+    // doing so (also guarded by <sleepersMutex>)
+    std::atomic<bool> autoAdvance{false};
+    bool advancing = false;
+
+    // Serialises set()/reset()/fastForward() calls made from different threads.  Recursive, as slots invoked from within these calls may
+    // themselves call them.
+    QMutex clockControlMutex{QMutex::Recursive};
+
+    // Whether faked time is frozen, only moving on set()/fastForward() calls rather than also in lockstep with real time
+    std::atomic<bool> frozen{false};
+
+    // Rate faked time proceeds relative to real time when not frozen, along with fraction of a mS carried over between idle timer ticks
+    std::atomic<double> rate{1.0};
+    double lockstepRemainder = 0;
+
+    // Lockstep statistics since rate was last set, guarded by <clockControlMutex>
+    qint64      rateStatsRealNS     = 0;
+    qint64      rateStatsFakedNS    = 0;
+    qint64      rateStatsBusyNS     = 0;
+    uint64_t    rateStatsLateTicks  = 0;
+
+    // Idle timer state, declared here rather than within setupIdleTimer() function so it can be reset from sanitiseTimers()
+    std::atomic<qint64> fakedTimeAtLastIdleTimerTick{-1};
+    std::atomic<qint64> realTimeAtLastIdleTimerTick{-1};
+
+    // Time jumped to by each of the most recent set()/reset() calls, with <timeJumpGeneration> counting calls.  QElapsedTimers record
+    // the generation they were started in, allowing any started before a jump back in time to lazily be restarted at the point jumped
+    // to on next use, rather than having to track every timer.
+    QReadWriteLock timeJumpsLock;
+    std::atomic<quint32> timeJumpGeneration{0};
+    std::deque<qint64> timeJumps;
+
+    // Shards in order of creation, along with index by thread.  Shards of finished threads with nothing left scheduled are pruned by
+    // pruneTimerShards(), so are shared with snapshots & timer cleanup handlers still making use of them.
+    QReadWriteLock timerShardsLock;
+    std::vector<std::shared_ptr<TimerShard>> timerShards;
+    std::unordered_map<const QThread*, TimerShard*> timerShardsByThread;
+};
 
-inline static qint64 QElapsedTimer_nsecsElapsed_shim(QElapsedTimer* timer)
+// Domains created via. createTimeDomain(), and threads bound to them, guarded by <timeDomainsLock>.  Domains are never destroyed, so
+// references to them also remain valid for the lifetime of the process.  <timeDomainBindingsGeneration> is incremented on every change
+// to thread bindings, allowing threads to cache their own domain until it changes.
+static TimeDomain defaultDomain;
+static QReadWriteLock timeDomainsLock;
+static std::vector<std::unique_ptr<TimeDomain>> timeDomains;
+static std::unordered_map<const QThread*, TimeDomain*> timeDomainBindings;
+static std::atomic<quint64> timeDomainBindingsGeneration(1);
+
+// Data structure used for timer schedules of new shards
+static std::atomic<TimerStore> timerStore(TimerStore::Heap);
+
+//------------------------------------------------------------------------------------------------------------------------
+// Idle timer, set up by setupIdleTimer()
+
+static constexpr int idleTimerLockstepInterval = 10;    // mS
+
+static QTimer* idleTimer = nullptr;
+static std::atomic<QObject*> idleTimerRearmer(nullptr);
+
+// Real time (nS since epoch) idle timer is next due to fire (max. qint64 value if stopped), and whether a request to re-arm it has been
+// posted to its thread but not yet actioned
+static std::atomic<qint64> idleTimerDueTime(std::numeric_limits<qint64>::max());
+static std::atomic<bool> idleTimerRearmPending(false);
+
+// Lives in the same thread as idle timer, re-arming it on behalf of other threads
+class IdleTimerRearmer: public QObject
 {
-    // Not currently supported
-    assert(false);
-    return -1;
-}
+public:
+    bool event(QEvent* event) override;
+
+    static QEvent::Type eventType(void)
+    {
+        static const QEvent::Type type = static_cast<QEvent::Type>(QEvent::registerEventType());
+        return type;
+    }
+};
+
+static void requestIdleTimerRearm(qint64 dueTime);
 
-inline static qint64 QElapsedTimer_msecsTo_shim(QElapsedTimer* timer, const QElapsedTimer&)
+static int lockstepInterval(const TimeDomain& domain)
 {
-    // Not currently supported
-    assert(false);
-    return -1;
+    // Tick faster when faked time runs faster than real time, so it advances in steps of no more than 10mS real time equivalent where
+    // possible
+    return qRound(qBound(1.0, idleTimerLockstepInterval / domain.rate.load(), double(idleTimerLockstepInterval)));
 }
 
+// Histogram of how late (in real time) timeouts are generated while tracking real time
+static std::atomic<uint64_t> latenessBuckets[latenessHistogramBuckets];
+
 //------------------------------------------------------------------------------------------------------------------------
-// QTimer method shims.
+// Statistics, see stats()
+//
+// Counters are kept per thread, each only ever written by its own thread so they can be bumped with relaxed loads/stores rather than
+// atomic read-modify-writes, cheap enough for the clock shims.  Each thread's counters are linked into <threadStatsList> on first use,
+// and carried over into <retiredStats> as the thread exits.  Counters are trivially constructed, so remain usable from other threads'
+// thread_local destructors (counts made after the thread's own counters retire are lost).
 
-class QTimerIdAccessor: public QObject
+enum StatsCounter
 {
-public:
-    int id;
+    timeoutsCounter,
+    eventPumpsCounter,
+    elapsedTimerStartsCounter,
+    clockReadsCounter,
+    fastForwardedNSCounter,
+    fastForwardRealNSCounter,
+    statsCounters
 };
 
-static constexpr int inactiveTimerID    = -1;
-static constexpr int fakeActiveTimerID  = 0;    // Value considered active by QTimer, but not by QObject::killTimer();
+struct ThreadStats
+{
+    std::atomic<uint64_t> counters[statsCounters];
+    bool registered;
+    ThreadStats* next;
+};
 
+static std::mutex threadStatsMutex;
+static ThreadStats* threadStatsList = nullptr;
+static uint64_t retiredStats[statsCounters];
+static uint64_t statsBaseline[statsCounters];
 
-inline static void QTimer_start_shim(QTimer* timer)
-{
-    if (timer->isSingleShot() && (timer->interval() == 0))
-    {
-        // In case of zero interval single-shot timer, invoke real Qt5Base QTimer::singleShot() implementation, which performs deferred
-        // invocation of <slotObj> via queued signal-slot connection.
+// QTimers currently active, and most active at once, across all threads.  Unlike the counters above these are shared, as a peak is
+// only meaningful across all threads, but are only updated as timers start & stop.
+static std::atomic<int64_t> activeTimers(0);
+static std::atomic<int64_t> peakActiveTimers(0);
 
-        // NOTE: This overload of QTimer::singleShot(), taking a functor argument, hasn't been shimmed
-        QTimer::singleShot(0, [=](){emit timer->timeout({});});
+//------------------------------------------------------------------------------------------------------------------------
+// Timeline trace, see startTrace()
 
-        return;
-    }
+// Fixed size record of a single fastForward() call or QTimer timeout, so that recording one never allocates.  Faked (virtual) times are
+// nS since epoch on the domain's faked clock, a timeout's start & end both being the time it was due, real times nS on the monotonic
+// clock.
+struct TraceRecord
+{
+    enum Kind: quint8
+    {
+        FastForward,
+        Timeout
+    };
+
+    const void*         timer;
+    const TimeDomain*   domain;
+    qint64              virtualStartNS;
+    qint64              virtualEndNS;
+    qint64              realStartNS;
+    qint64              realEndNS;
+    quint32             thread;         // Index into <traceThreadNames>
+    Kind                kind;
+    char                name[43];       // Timer's objectName (class name if it has none), truncated & nul terminated
+};
 
-    qTimerDueTimes[timer] = QDateTime::currentMSecsSinceEpoch() + timer->interval();
+// Ring buffer holding most recent <traceCapacity> records, preallocated by startTrace(), with <traceNext> counting records ever written.
+// Records are written with <traceLock> held for read, each writer claiming a slot of its own, so only starting/exporting a trace need
+// exclude them.  <tracing> allows timeouts to bypass the lock entirely when not tracing.
+static QReadWriteLock traceLock;
+static std::atomic<bool> tracing(false);
+static std::unique_ptr<TraceRecord[]> traceRecords;
+static size_t traceCapacity = 0;
+static std::atomic<quint64> traceNext(0);
 
-    reinterpret_cast<QTimerIdAccessor*>(timer)->id = fakeActiveTimerID;
+// Names of threads records have been written from, by order they first wrote one, guarded by <traceThreadNamesMutex>
+static std::mutex traceThreadNamesMutex;
+static std::vector<std::string> traceThreadNames;
 
-    // Have to use event handler connected to QObject::destroyed() signal to remove timer from <qTimerDueTimes> on destruction, rather than shimming QTimer::~QTimer()
-    // destructors (_ZN6QTimerD0Ev etc.), as the shim destructors is not invoked in the case of dynamically allocated timers, (they instead invoke their
-    // real virtual destructor via their virtual method table.)
-    QObject::connect(timer, &QObject::destroyed, [](QObject* obj)   {qTimerDueTimes.erase((QTimer*)obj);});
-}
+//------------------------------------------------------------------------------------------------------------------------
 
-inline static void QTimer_start_shim(QTimer* timer, int interval)
-{
-    reinterpret_cast<QTimerIdAccessor*>(timer)->id = inactiveTimerID;
+// Repeating QTimers explicitly enabled/disabled for skip-ahead, and objectName wildcard patterns enabling it for any other timers,
+// guarded by <skipAheadLock>.  <skipAheadConfigured> allows timers to bypass the lock entirely when skip-ahead isn't in use.
+static QReadWriteLock skipAheadLock;
+static std::atomic<bool> skipAheadConfigured(false);
+static std::unordered_map<const QTimer*, bool> skipAheadTimers;
+static std::vector<QRegExp> skipAheadPatterns;
 
-    assert(pQt5Core_QTimer_setInterval != nullptr);
-    pQt5Core_QTimer_setInterval(timer, interval);
+// Handler to be notified of ticks skipped by skip-ahead timers, also guarded by <skipAheadLock>
+static SkippedTicksHandler skippedTicksHandler;
 
-    timer->start();
-}
+//------------------------------------------------------------------------------------------------------------------------
 
-inline static void QTimer_stop_shim(QTimer* timer)
+static TimeDomain& boundTimeDomain(const QThread* thread)
 {
-    reinterpret_cast<QTimerIdAccessor*>(timer)->id = inactiveTimerID;
+    // Domain <thread> is bound to
+    QReadLocker lock(&timeDomainsLock);
+
+    auto ii = timeDomainBindings.find(thread);
 
-    qTimerDueTimes.erase(timer);
+    return (ii != timeDomainBindings.end()) ? *ii->second : defaultDomain;
 }
 
-inline static void QTimer_setInterval_shim(QTimer* timer, int interval)
+inline static TimeDomain& callingThreadTimeDomain(void)
 {
-    bool wasActive = timer->isActive();
-
-    reinterpret_cast<QTimerIdAccessor*>(timer)->id = inactiveTimerID;
+    // Calling thread's domain, cached by thread until thread bindings next change
+    thread_local TimeDomain*    cachedDomain        = nullptr;
+    thread_local quint64        cachedGeneration    = 0;
 
-    assert(pQt5Core_QTimer_setInterval != nullptr);
-    pQt5Core_QTimer_setInterval(timer, interval);
+    quint64 generation = timeDomainBindingsGeneration.load(std::memory_order_acquire);
 
-    if (wasActive)
+    if (cachedGeneration != generation)
     {
-        timer->start();
+        cachedDomain        = &boundTimeDomain(QThread::currentThread());
+        cachedGeneration    = generation;
     }
+
+    return *cachedDomain;
 }
 
-inline static int QTimer_remainingTime_shim(QTimer* timer)
+static void registerThreadStats(ThreadStats& stats);
+
+inline static void count(StatsCounter counter, uint64_t n = 1)
 {
-    auto ii = qTimerDueTimes.find(timer);
+    thread_local ThreadStats stats;
 
-    if (ii != qTimerDueTimes.end())
-    {
-        return ii->second  - QDateTime::currentMSecsSinceEpoch();
-    }
-    else
+    if (Q_UNLIKELY(!stats.registered))
     {
-        return -1;
+        registerThreadStats(stats);
     }
+
+    // Only ever written by calling thread
+    stats.counters[counter].store(stats.counters[counter].load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
 }
 
-inline static void QTimer_singleShotImpl_shim(  int msec,
-                                                Qt::TimerType timerType,
-                                                const QObject *receiver,
-                                                QtPrivate::QSlotObjectBase *slotObj)
+static void countActiveTimers(int64_t change)
 {
-    if (msec == 0)
+    int64_t active  = activeTimers.fetch_add(change, std::memory_order_relaxed) + change;
+    int64_t peak    = peakActiveTimers.load(std::memory_order_relaxed);
+
+    while ((active > peak) && !peakActiveTimers.compare_exchange_weak(peak, active, std::memory_order_relaxed))
     {
-        // In case of zero interval single-shot timer, invoke real Qt5Base QTimer::singelShot() implementation, which performs deferred
-        // invocation of <slotObj> via queued signal-slot connection.
-        assert(pQt5Core_QTimer_singleShotImpl != nullptr);
-        pQt5Core_QTimer_singleShotImpl(0, timerType, receiver, slotObj);
-        return;
     }
+}
 
+inline static qint64 fakedTime(void)
+{
+    // Lock-free read of calling thread's faked current time (mS since epoch), -1 if not currently faking
+    count(clockReadsCounter);
 
-    // NOTE: Function expected to take ownership of <slotObj>, but dispose of it via. destroyIfLastRef() call rather than delete
-
-    QTimer* pTimer = new QTimer();
-
-    pTimer->setInterval(msec);
-    pTimer->setSingleShot(true);
-
-    QObject::connect(pTimer, &QTimer::timeout, [=](void){
-                                                            void *empty_argv[] = { nullptr };
+    qint64 nsSinceEpoch = callingThreadTimeDomain().fakedNSSinceEpoch.load(std::memory_order_acquire);
 
-                                                            slotObj->call(const_cast<QObject*>(receiver), empty_argv);
+    return (nsSinceEpoch == -1) ? -1 : nsSinceEpoch / nsPerMS;
+}
 
-                                                            slotObj->destroyIfLastRef();
+inline static int realClockGettime(clockid_t clockId, struct timespec* ts)
+{
+    return pLibc_clock_gettime(clockId, ts);
+}
 
-                                                            qTimerDueTimes.erase(pTimer);
+inline static int realPoll(struct pollfd* fds, nfds_t nfds, int timeout)
+{
+    return pLibc_poll(fds, nfds, timeout);
+}
 
-                                                            reinterpret_cast<QTimerIdAccessor*>(pTimer)->id = inactiveTimerID;
+static void realSleep(qint64 ns)
+{
+    struct timespec duration;
 
-                                                            delete pTimer;
-                                                        });
+    duration.tv_sec     = ns / 1000000000;
+    duration.tv_nsec    = ns % 1000000000;
 
-    pTimer->start();
+    pLibc_nanosleep(&duration, nullptr);
 }
 
-//------------------------------------------------------------------------------------------------------------------------
-// Declaration of compiler specific shim function wrappers with names matching the C++ name-mangled symbols corresponding
-// to methods exported by libQt5Core.so, overriding libQt5Core originals due to LD_PRELOAD.  Functions are declared with "C"
-// external linkage in order to prevent further mangling.
-//
-// Mangled names discovered by examining "objdump -t .../libQt5Core.so" output
+static qint64 realClockTime(clockid_t clockId)
+{
+    // Real time of <clockId> (nS), read via. vDSO without a system call for the usual clocks
+    struct timespec ts;
 
-#ifdef __GNUC__
+    realClockGettime(clockId, &ts);
 
-// Overrides of C++ name-mangled identifiers generated by GCC compiling Qt5 (verified for Qt 5.9 & 5.15)
+    return static_cast<qint64>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
 
-extern "C" QDateTime _ZN9QDateTime15currentDateTimeEv(void)
+static qint64 realTime(void)
 {
-    return QDateTime_currentDateTime_shim();
+    // Real current time, nS since epoch
+    return realClockTime(CLOCK_REALTIME);
 }
 
-extern "C" QDateTime _ZN9QDateTime18currentDateTimeUtcEv(void)
+static qint64 monotonicTime(void)
 {
-    return QDateTime_currentDateTimeUtc_shim();
+    // Real monotonic clock (nS), the same clock real QElapsedTimer & QDeadlineTimer use
+    return realClockTime(CLOCK_MONOTONIC);
 }
 
-extern "C" qint64 _ZN9QDateTime22currentMSecsSinceEpochEv(void)
+// Nesting depth of faked time advances made by calling thread, those made from slots during another advance being nested within it
+static thread_local int fastForwardDepth = 0;
+
+static void countFastForward(qint64 fakedNS, qint64 realStartNS)
 {
-    return QDateTime_currentMSecsSinceEpoch_shim();
+    // Count faked time moved on by an explicit fast-forward or a faked sleep/wait (but not lockstep with real time), with real time
+    // spent only counted for the outermost of nested advances, as it already includes that of those nested
+    count(fastForwardedNSCounter, static_cast<uint64_t>(qMax<qint64>(0, fakedNS)));
+
+    if (fastForwardDepth == 0)
+    {
+        count(fastForwardRealNSCounter, static_cast<uint64_t>(monotonicTime() - realStartNS));
+    }
 }
 
-extern "C" qint64 _ZN9QDateTime21currentSecsSinceEpochEv(void)
+static qint64 currentMonotonicTime(const TimeDomain& domain)
 {
-    return QDateTime_currentSecsSinceEpoch_shim();
+    // Current time on <domain>'s monotonic clock (nS)
+    qint64 nsSinceReference = domain.fakedMonotonicNS.load(std::memory_order_acquire);
+
+    if (nsSinceReference == -1)
+    {
+        return monotonicTime() + domain.monotonicLeadNS;
+    }
 
+    return nsSinceReference;
 }
 
-extern "C" QTime _ZN5QTime11currentTimeEv(void)
+static qint64 currentTime(const TimeDomain& domain)
 {
-    return QTime_currentTime_shim();
+    // Current time in <domain> (nS since epoch), which is real time if it isn't currently faking
+    qint64 nsSinceEpoch = domain.fakedNSSinceEpoch.load(std::memory_order_acquire);
+
+    if (nsSinceEpoch == -1)
+    {
+        return realTime();
+    }
+
+    return nsSinceEpoch;
 }
 
-extern "C" bool _ZNK13QElapsedTimer7isValidEv(QElapsedTimer* timer)
+static std::vector<TimeDomain*> allTimeDomains(void)
 {
-    return QElapsedTimer_isValid_shim(timer);
+    // Snapshot of all domains, default domain first
+    QReadLocker lock(&timeDomainsLock);
+
+    std::vector<TimeDomain*> domains(1, &defaultDomain);
+
+    for (const std::unique_ptr<TimeDomain>& domain : timeDomains)
+    {
+        domains.push_back(domain.get());
+    }
+
+    return domains;
+}
+
+static TimerSchedule* newTimerSchedule(TimerStore store)
+{
+    switch (store)
+    {
+        case TimerStore::Heap:          return new HeapTimerSchedule();
+        case TimerStore::TimingWheel:   return new WheelTimerSchedule();
+    }
+
+    assert(false);
+    return nullptr;
+}
+
+static TimerShard* findTimerShard(const TimeDomain& domain, const QThread* thread)
+{
+    // Caller expected to hold domain's <timerShardsLock>
+    auto ii = domain.timerShardsByThread.find(thread);
+
+    return (ii != domain.timerShardsByThread.end()) ? ii->second : nullptr;
+}
+
+static void pruneTimerShards(TimeDomain& domain)
+{
+    // Drop shards of finished threads with nothing left scheduled or pending.  Caller expected to hold domain's <timerShardsLock> for
+    // writing.
+    auto retired = [&domain](const std::shared_ptr<TimerShard>& shard) -> bool
+    {
+        QMutexLocker lock(&shard->mutex);
+
+        if (!shard->finished || !shard->schedule->empty() || (shard->pendingBatches > 0))
+        {
+            return false;
+        }
+
+        domain.timerShardsByThread.erase(shard->thread);
+
+        return true;
+    };
+
+    domain.timerShards.erase(std::remove_if(domain.timerShards.begin(), domain.timerShards.end(), retired), domain.timerShards.end());
+}
+
+static TimerShard& timerShard(const QObject* object)
+{
+    // Shard tracking timers owned by the same thread as <object>, within the domain that thread is bound to, created on first use
+    QThread* thread = object->thread();
+
+    bool isCurrentThread = (thread == QThread::currentThread());
+
+    TimeDomain& domain = isCurrentThread ? callingThreadTimeDomain() : boundTimeDomain(thread);
+
+    // Cache shard of calling thread, by far the most common case being a thread starting/stopping its own timers
+    thread_local TimerShard* currentThreadShard = nullptr;
+
+    if (isCurrentThread && (currentThreadShard != nullptr) && (currentThreadShard->thread == thread) && (currentThreadShard->domain == &domain))
+    {
+        return *currentThreadShard;
+    }
+
+    TimerShard* shard = nullptr;
+
+    {
+        QReadLocker lock(&domain.timerShardsLock);
+        shard = findTimerShard(domain, thread);
+    }
+
+    if (shard == nullptr)
+    {
+        QWriteLocker lock(&domain.timerShardsLock);
+
+        // Check again, in case another thread has created shard in the meantime
+        shard = findTimerShard(domain, thread);
+
+        if (shard == nullptr)
+        {
+            pruneTimerShards(domain);
+
+            domain.timerShards.push_back(std::make_shared<TimerShard>());
+
+            shard           = domain.timerShards.back().get();
+            shard->domain   = &domain;
+            shard->thread   = thread;
+            shard->schedule.reset(newTimerSchedule(timerStore));
+
+            domain.timerShardsByThread[thread] = shard;
+        }
+    }
+
+    if (isCurrentThread)
+    {
+        // Have calling thread mark each of its shards finished as it exits.  A thread only ever has timers in shards it has passed
+        // through here for, so shards of threads that never start a timer themselves are left unmarked (and in place, though empty).
+        struct ShardsFinisher
+        {
+            std::vector<std::weak_ptr<TimerShard>> shards;
+
+            ~ShardsFinisher()
+            {
+                for (const std::weak_ptr<TimerShard>& shard : shards)
+                {
+                    if (std::shared_ptr<TimerShard> finishedShard = shard.lock())
+                    {
+                        finishedShard->finished = true;
+                    }
+                }
+            }
+        };
+
+        thread_local ShardsFinisher finisher;
+
+        QMutexLocker lock(&shard->mutex);
+
+        if (shard->finished)
+        {
+            // Shard belonged to a since finished thread whose QThread happened to share the same address, and any dispatcher will
+            // have been left behind in the old thread
+            shard->finished = false;
+            shard->dispatcher.reset();
+        }
+
+        lock.unlock();
+
+        if (std::none_of(finisher.shards.begin(), finisher.shards.end(),
+                         [shard](const std::weak_ptr<TimerShard>& other){ return other.lock().get() == shard; }))
+        {
+            finisher.shards.push_back(shard->shared_from_this());
+        }
+
+        currentThreadShard = shard;
+    }
+
+    return *shard;
+}
+
+static std::vector<std::shared_ptr<TimerShard>> allTimerShards(TimeDomain& domain)
+{
+    // Snapshot of domain's current shards, allowing them to be worked through without holding <timerShardsLock>
+    QReadLocker lock(&domain.timerShardsLock);
+
+    return domain.timerShards;
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------
+// Shim functions faking selected Qt5Core library functionality.
+
+//-----------------------------------------------------------------------------------------------------------------------
+// QDateTime method shims
+//
+// Converting faked time to local time via. Qt goes through localtime_r() (and its timezone lock) on every call, so each thread caches
+// a local QDateTime along with the span of time around it (up to the neighbouring timezone transitions) over which local time's
+// offset from UTC stays the same.  Faked local QDateTime & QTime values within that span are derived from the cached ones without
+// any timezone work.
+//
+// NOTE: Assumes the local timezone isn't changed while running, other than just before a reset(), which discards every thread's cache.
+
+static std::atomic<quint64> localTimeCacheGeneration{0};
+
+struct LocalTimeCache
+{
+    quint64     generation      = 0;
+
+    // Span (mS since epoch) over which cached offset holds, initially empty
+    qint64      validFrom       = std::numeric_limits<qint64>::max();
+    qint64      validUntil      = std::numeric_limits<qint64>::min();
+
+    qint64      msSinceEpoch    = 0;
+    QDateTime   dateTime;
+    qint64      offsetMS        = 0;
+};
+
+// Qt 5 holds QDateTimes that fit in a pointer inline, local time ones as local mS since epoch above an 8 bit status field, the
+// lowest bit of which flags the short form
+static constexpr quintptr shortDateTimeFlag = 0x01;
+static constexpr int shortDateTimeShift     = 8;
+
+static_assert(sizeof(QDateTime) == sizeof(quintptr), "QDateTime expected to be pointer sized");
+
+// Set by initialize() once the above layout has been confirmed to match that of the Qt Core library actually loaded, local QDateTimes
+// otherwise being converted by Qt in full
+static std::atomic<bool> shortDateTimeLayoutVerified(false);
+
+static quintptr shortDateTimeData(const QDateTime& dateTime)
+{
+    quintptr data;
+
+    memcpy(&data, &dateTime, sizeof(data));
+
+    return data;
+}
+
+static QDateTime shiftedShortDateTime(quintptr data, qint64 shiftMS)
+{
+    // Short form local QDateTime <data> moved on by <shiftMS>, without any timezone work
+    qint64 localMS = (static_cast<qint64>(data) >> shortDateTimeShift) + shiftMS;
+
+    data = (data & ((1 << shortDateTimeShift) - 1)) | (static_cast<quintptr>(localMS) << shortDateTimeShift);
+
+    QDateTime dateTime;
+
+    memcpy(static_cast<void*>(&dateTime), &data, sizeof(data));
+
+    return dateTime;
+}
+
+static bool verifyShortDateTimeLayout(void)
+{
+    // Build known local QDateTimes and check that both their inline mS since epoch & status field decode as expected, and that
+    // shifting one yields the other
+    static constexpr qint64 probeMS = 1600000000000LL;
+    static constexpr qint64 shiftMS = 1000;
+
+    QDateTime probe     = QDateTime::fromMSecsSinceEpoch(probeMS);
+    QDateTime expected  = QDateTime::fromMSecsSinceEpoch(probeMS + shiftMS);
+
+    quintptr probeData      = shortDateTimeData(probe);
+    quintptr expectedData   = shortDateTimeData(expected);
+
+    if (((probeData & shortDateTimeFlag) == 0) ||
+        ((static_cast<qint64>(probeData) >> shortDateTimeShift) != probeMS + probe.offsetFromUtc() * 1000LL) ||
+        ((probeData & ((1 << shortDateTimeShift) - 1)) != (expectedData & ((1 << shortDateTimeShift) - 1))))
+    {
+        return false;
+    }
+
+    QDateTime shifted = shiftedShortDateTime(probeData, shiftMS);
+
+    return shifted.isValid() && (shifted.timeSpec() == Qt::LocalTime) && (shifted.toMSecsSinceEpoch() == probeMS + shiftMS) &&
+           (shortDateTimeData(shifted) == expectedData);
+}
+
+static const LocalTimeCache& localTimeCache(qint64 msSinceEpoch)
+{
+    thread_local LocalTimeCache cache;
+
+    quint64 generation = localTimeCacheGeneration.load(std::memory_order_relaxed);
+
+    if ((msSinceEpoch < cache.validFrom) || (msSinceEpoch >= cache.validUntil) || (cache.generation != generation))
+    {
+        cache.generation    = generation;
+        cache.msSinceEpoch  = msSinceEpoch;
+        cache.dateTime      = QDateTime::fromMSecsSinceEpoch(msSinceEpoch);
+        cache.offsetMS      = cache.dateTime.offsetFromUtc() * 1000LL;
+
+        QTimeZone zone = QTimeZone::systemTimeZone();
+
+        cache.validFrom     = std::numeric_limits<qint64>::min();
+        cache.validUntil    = std::numeric_limits<qint64>::max();
+
+        if (zone.isValid() && zone.hasTransitions())
+        {
+            QDateTime previous  = zone.previousTransition(QDateTime::fromMSecsSinceEpoch(msSinceEpoch + 1, Qt::UTC)).atUtc;
+            QDateTime next      = zone.nextTransition(QDateTime::fromMSecsSinceEpoch(msSinceEpoch, Qt::UTC)).atUtc;
+
+            if (previous.isValid())
+            {
+                cache.validFrom = previous.toMSecsSinceEpoch();
+            }
+
+            if (next.isValid())
+            {
+                cache.validUntil = next.toMSecsSinceEpoch();
+            }
+        }
+    }
+
+    return cache;
+}
+
+static QDateTime localDateTime(qint64 msSinceEpoch)
+{
+    // Local QDateTime for <msSinceEpoch>, shifted from the cached one by patching its inline local mS since epoch
+    if (!shortDateTimeLayoutVerified)
+    {
+        return QDateTime::fromMSecsSinceEpoch(msSinceEpoch);
+    }
+
+    const LocalTimeCache& cache = localTimeCache(msSinceEpoch);
+
+    quintptr data = shortDateTimeData(cache.dateTime);
+
+    if ((data & shortDateTimeFlag) == 0)
+    {
+        // Not held inline after all (date far out of range etc.)
+        return QDateTime::fromMSecsSinceEpoch(msSinceEpoch);
+    }
+
+    return shiftedShortDateTime(data, msSinceEpoch - cache.msSinceEpoch);
+}
+
+inline static QDateTime QDateTime_currentDateTime_shim(void)
+{
+    qint64 msSinceEpoch = fakedTime();
+
+    if (msSinceEpoch == -1)
+    {
+        // Return real value from underlying Qt Core library
+        return pQt5Core_QDateTime_currentDateTime();
+    }
+    else
+    {
+        return localDateTime(msSinceEpoch);
+    }
+}
+
+inline static QDateTime QDateTime_currentDateTimeUtc_shim(void)
+{
+    qint64 msSinceEpoch = fakedTime();
+
+    if (msSinceEpoch == -1)
+    {
+        // Return real value from underlying Qt Core library
+        return pQt5Core_QDateTime_currentDateTimeUtc();
+    }
+    else
+    {
+        return QDateTime::fromMSecsSinceEpoch(msSinceEpoch, Qt::UTC);
+    }
+}
+
+inline static qint64 QDateTime_currentMSecsSinceEpoch_shim(void)
+{
+    qint64 msSinceEpoch = fakedTime();
+
+    if (msSinceEpoch == -1)
+    {
+        // Return real value from underlying Qt Core library
+        return pQt5Core_QDateTime_currentMSecsSinceEpoch();
+    }
+    else
+    {
+        return msSinceEpoch;
+    }
+}
+
+inline static qint64 QDateTime_currentSecsSinceEpoch_shim(void)
+{
+    qint64 msSinceEpoch = fakedTime();
+
+    if (msSinceEpoch == -1)
+    {
+        // Return real value from underlying Qt Core library
+        return pQt5Core_QDateTime_currentSecsSinceEpoch();
+    }
+    else
+    {
+        return msSinceEpoch / 1000;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+// QTime method shims
+
+inline static QTime QTime_currentTime_shim(void)
+{
+    qint64 msSinceEpoch = fakedTime();
+
+    if (msSinceEpoch == -1)
+    {
+        return QDateTime::currentDateTime().time();
+    }
+
+    // Local time of day, from cached offset
+    static constexpr qint64 msPerDay = 24 * 60 * 60 * 1000;
+
+    qint64 localMS = msSinceEpoch + localTimeCache(msSinceEpoch).offsetMS;
+
+    return QTime::fromMSecsSinceStartOfDay(static_cast<int>(((localMS % msPerDay) + msPerDay) % msPerDay));
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+// QElapsedTimer method shims.
+//
+// Start time is held within the QElapsedTimer instance itself, in place of its real clock values, so there is no need to track
+// instances (which is just as well, as QElapsedTimer has no destructor to shim).  Timers started while not faking time use the
+// monotonic clock, as the real QElapsedTimer does, only read against the domain's clock while it is faking time.  Timers are never
+// written to other than by start()/restart()/invalidate(), so the const methods are as safe to call concurrently as Qt's own.
+
+class QElapsedTimerAccessor
+{
+public:
+    qint64 t1;  // Start time, nS
+    qint64 t2;  // Tag in upper 32 bits, domain's time jump generation as of start in lower 32 bits
+};
+
+// Tags identifying timers started via. QElapsedTimer_start_shim(), with start time on domain's (faked) clock or the monotonic clock
+// respectively.  Both distinct from upper half of Qt's invalid timer marker (0x80000000).
+static constexpr quint32 fakedElapsedTimerTag       = 0x46414b45;
+static constexpr quint32 monotonicElapsedTimerTag   = 0x4d4f4e4f;
+static constexpr qint64 invalidElapsedTimer         = std::numeric_limits<qint64>::min();
+
+static quint32 elapsedTimerTag(const QElapsedTimer* timer)
+{
+    return static_cast<quint32>(static_cast<quint64>(reinterpret_cast<const QElapsedTimerAccessor*>(timer)->t2) >> 32);
+}
+
+static qint64 taggedTimeJumpGeneration(quint32 tag, quint32 generation)
+{
+    return static_cast<qint64>((static_cast<quint64>(tag) << 32) | generation);
+}
+
+static bool isMonotonicElapsedTimer(const TimeDomain& domain, const QElapsedTimer* timer)
+{
+    // Timer started on monotonic clock, and domain still not faking time
+    return (elapsedTimerTag(timer) == monotonicElapsedTimerTag) && (domain.fakedNSSinceEpoch == -1);
+}
+
+static qint64 elapsedTimerStartTime(TimeDomain& domain, const QElapsedTimer* timer)
+{
+    // Start time of <timer> on <domain>'s clock, worked out afresh on every use rather than written back to the timer
+    const QElapsedTimerAccessor& accessor = reinterpret_cast<const QElapsedTimerAccessor&>(*timer);
+
+    quint32 generation  = static_cast<quint32>(accessor.t2);
+    qint64 startTime    = accessor.t1;
+
+    if (elapsedTimerTag(timer) == monotonicElapsedTimerTag)
+    {
+        // Domain has started faking time since timer was started, carry on from equivalent real start time
+        startTime = realTime() - (monotonicTime() - startTime);
+    }
+
+    if (generation != domain.timeJumpGeneration)
+    {
+        // Faked time has been set since timer was started.  If set back to before timer's start time, take timer as restarted at time
+        // jumped to, to avoid possibility of returning nonsensical negative elapsed time.  Timers outliving more than <timeJumpHistory>
+        // jumps are only checked against those remembered.
+        QReadLocker lock(&domain.timeJumpsLock);
+
+        size_t jumps = qMin<size_t>(domain.timeJumpGeneration - generation, domain.timeJumps.size());
+
+        for (size_t i = domain.timeJumps.size() - jumps; i < domain.timeJumps.size(); ++i)
+        {
+            startTime = qMin(startTime, domain.timeJumps[i]);
+        }
+    }
+
+    return startTime;
+}
+
+inline static bool QElapsedTimer_isValid_shim(const QElapsedTimer* timer)
+{
+    quint32 tag = elapsedTimerTag(timer);
+
+    return (tag == fakedElapsedTimerTag) || (tag == monotonicElapsedTimerTag);
+}
+
+inline static qint64 QElapsedTimer_nsecsElapsed_shim(QElapsedTimer* timer);
+
+inline static qint64 QElapsedTimer_elapsed_shim(QElapsedTimer* timer)
+{
+    // Qt documentation for "real" QElapsedTimer describes unspecified behaviour when calling elapsed(), hasExpired() etc
+    // on invalid timer.
+    return QElapsedTimer_nsecsElapsed_shim(timer) / nsPerMS;
+}
+
+inline static bool _ZNK13QElapsedTimer_hasExpired_shim(QElapsedTimer* timer, qint64 timeout)
+{
+    return timer->elapsed() >= timeout;
+}
+
+inline static void QElapsedTimer_invalidate_shim(QElapsedTimer* timer)
+{
+    QElapsedTimerAccessor* accessor = reinterpret_cast<QElapsedTimerAccessor*>(timer);
+
+    accessor->t1 = invalidElapsedTimer;
+    accessor->t2 = invalidElapsedTimer;
+}
+
+inline static void QElapsedTimer_start_shim(QElapsedTimer* timer)
+{
+    count(elapsedTimerStartsCounter);
+    count(clockReadsCounter);
+
+    TimeDomain& domain = callingThreadTimeDomain();
+
+    QElapsedTimerAccessor* accessor = reinterpret_cast<QElapsedTimerAccessor*>(timer);
+
+    // Read generation before time, so a concurrent jump is caught on next use rather than missed
+    quint32 generation = domain.timeJumpGeneration;
+
+    if (domain.fakedNSSinceEpoch == -1)
+    {
+        accessor->t2 = taggedTimeJumpGeneration(monotonicElapsedTimerTag, generation);
+        accessor->t1 = monotonicTime();
+    }
+    else
+    {
+        accessor->t2 = taggedTimeJumpGeneration(fakedElapsedTimerTag, generation);
+        accessor->t1 = currentTime(domain);
+    }
+}
+
+inline static qint64 QElapsedTimer_restart_shim(QElapsedTimer* timer)
+{
+    qint64 elapsed = timer->elapsed();
+
+    timer->start();
+
+    return elapsed;
+}
+
+inline static qint64 QElapsedTimer_nsecsElapsed_shim(QElapsedTimer* timer)
+{
+    assert(QElapsedTimer_isValid_shim(timer));
+
+    count(clockReadsCounter);
+
+    TimeDomain& domain = callingThreadTimeDomain();
+
+    if (isMonotonicElapsedTimer(domain, timer))
+    {
+        // Not faking time, same cost as real QElapsedTimer bar the domain lookup
+        return monotonicTime() - reinterpret_cast<QElapsedTimerAccessor*>(timer)->t1;
+    }
+
+    qint64 startTime = elapsedTimerStartTime(domain, timer);
+
+    return currentTime(domain) - startTime;
+}
+
+inline static qint64 QElapsedTimer_msecsSinceReference_shim(QElapsedTimer* timer)
+{
+    // Reference being system boot for timers on the monotonic clock, as with real QElapsedTimer, or the epoch for faked ones
+    assert(QElapsedTimer_isValid_shim(timer));
+
+    TimeDomain& domain = callingThreadTimeDomain();
+
+    if (isMonotonicElapsedTimer(domain, timer))
+    {
+        return reinterpret_cast<QElapsedTimerAccessor*>(timer)->t1 / nsPerMS;
+    }
+
+    return elapsedTimerStartTime(domain, timer) / nsPerMS;
+}
+
+inline static qint64 QElapsedTimer_msecsTo_shim(QElapsedTimer* timer, const QElapsedTimer& other)
+{
+    assert(QElapsedTimer_isValid_shim(timer));
+    assert(QElapsedTimer_isValid_shim(&other));
+
+    TimeDomain& domain = callingThreadTimeDomain();
+
+    if (isMonotonicElapsedTimer(domain, timer) && isMonotonicElapsedTimer(domain, &other))
+    {
+        return (reinterpret_cast<const QElapsedTimerAccessor*>(&other)->t1 - reinterpret_cast<QElapsedTimerAccessor*>(timer)->t1) / nsPerMS;
+    }
+
+    qint64 startTime        = elapsedTimerStartTime(domain, timer);
+    qint64 otherStartTime   = elapsedTimerStartTime(domain, &other);
+
+    return (otherStartTime - startTime) / nsPerMS;
+}
+
+inline static qint64 QElapsedTimer_secsTo_shim(QElapsedTimer* timer, const QElapsedTimer& other)
+{
+    return QElapsedTimer_msecsTo_shim(timer, other) / 1000;
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+// QDeadlineTimer method shims.
+//
+// Deadlines are held on the calling thread's domain's monotonic clock, in the same seconds/nS form as real QDeadlineTimer, so only
+// methods that read the clock need shimming.  Those that merely manipulate deadlines (deadline(), setDeadline(), addNSecs() etc.)
+// work as-is.
+
+class QDeadlineTimerAccessor
+{
+public:
+    qint64      t1;     // Seconds, or max. qint64 value if forever
+    unsigned    t2;     // nS
+    unsigned    type;
+};
+
+static qint64 deadlineTimerNS(const QDeadlineTimer* timer)
+{
+    const QDeadlineTimerAccessor* accessor = reinterpret_cast<const QDeadlineTimerAccessor*>(timer);
+
+    qint64 deadline;
+
+    if (__builtin_mul_overflow(accessor->t1, qint64(1000000000), &deadline) || __builtin_add_overflow(deadline, qint64(accessor->t2), &deadline))
+    {
+        return (accessor->t1 < 0) ? std::numeric_limits<qint64>::min() : std::numeric_limits<qint64>::max();
+    }
+
+    return deadline;
+}
+
+static void setDeadlineTimer(QDeadlineTimer* timer, qint64 nsFromNow, qint64 nsExtra, Qt::TimerType timerType)
+{
+    // Set deadline <nsFromNow> + <nsExtra> on from current monotonic time, saturating to forever (or the distant past) on overflow
+    count(clockReadsCounter);
+
+    QDeadlineTimerAccessor* accessor = reinterpret_cast<QDeadlineTimerAccessor*>(timer);
+
+    qint64 deadline;
+
+    accessor->type = timerType;
+
+    if (__builtin_add_overflow(currentMonotonicTime(callingThreadTimeDomain()), nsFromNow, &deadline) ||
+        __builtin_add_overflow(deadline, nsExtra, &deadline))
+    {
+        if ((nsFromNow > 0) || (nsExtra > 0))
+        {
+            *timer = QDeadlineTimer(QDeadlineTimer::Forever, timerType);
+            return;
+        }
+
+        deadline = std::numeric_limits<qint64>::min();
+    }
+
+    qint64 secs = deadline / 1000000000;
+    qint64 nsecs = deadline % 1000000000;
+
+    if (nsecs < 0)
+    {
+        secs -= 1;
+        nsecs += 1000000000;
+    }
+
+    accessor->t1 = secs;
+    accessor->t2 = static_cast<unsigned>(nsecs);
+}
+
+inline static QDeadlineTimer QDeadlineTimer_current_shim(Qt::TimerType timerType)
+{
+    QDeadlineTimer result;
+
+    setDeadlineTimer(&result, 0, 0, timerType);
+
+    return result;
+}
+
+inline static void QDeadlineTimer_setPreciseRemainingTime_shim(QDeadlineTimer* timer, qint64 secs, qint64 nsecs, Qt::TimerType timerType)
+{
+    if (secs == -1)
+    {
+        *timer = QDeadlineTimer(QDeadlineTimer::Forever, timerType);
+        return;
+    }
+
+    qint64 nsFromNow;
+
+    if (__builtin_mul_overflow(secs, qint64(1000000000), &nsFromNow))
+    {
+        nsFromNow = (secs < 0) ? std::numeric_limits<qint64>::min() : std::numeric_limits<qint64>::max();
+    }
+
+    setDeadlineTimer(timer, nsFromNow, nsecs, timerType);
+}
+
+inline static void QDeadlineTimer_setRemainingTime_shim(QDeadlineTimer* timer, qint64 msecs, Qt::TimerType timerType)
+{
+    if (msecs == -1)
+    {
+        *timer = QDeadlineTimer(QDeadlineTimer::Forever, timerType);
+        return;
+    }
+
+    QDeadlineTimer_setPreciseRemainingTime_shim(timer, msecs / 1000, (msecs % 1000) * nsPerMS, timerType);
+}
+
+inline static qint64 QDeadlineTimer_rawRemainingTimeNSecs_shim(const QDeadlineTimer* timer)
+{
+    count(clockReadsCounter);
+
+    qint64 remaining;
+
+    if (__builtin_sub_overflow(deadlineTimerNS(timer), currentMonotonicTime(callingThreadTimeDomain()), &remaining))
+    {
+        return std::numeric_limits<qint64>::min();
+    }
+
+    return remaining;
+}
+
+inline static qint64 QDeadlineTimer_remainingTimeNSecs_shim(const QDeadlineTimer* timer)
+{
+    if (timer->isForever())
+    {
+        return -1;
+    }
+
+    return qMax<qint64>(0, QDeadlineTimer_rawRemainingTimeNSecs_shim(timer));
+}
+
+inline static qint64 QDeadlineTimer_remainingTime_shim(const QDeadlineTimer* timer)
+{
+    if (timer->isForever())
+    {
+        return -1;
+    }
+
+    // Round up, as real QDeadlineTimer does, so deadline isn't reported as reached before it actually has been
+    qint64 remaining = QDeadlineTimer_remainingTimeNSecs_shim(timer);
+
+    return (remaining / nsPerMS) + (((remaining % nsPerMS) != 0) ? 1 : 0);
+}
+
+inline static bool QDeadlineTimer_hasExpired_shim(const QDeadlineTimer* timer)
+{
+    if (timer->isForever())
+    {
+        return false;
+    }
+
+    return QDeadlineTimer_rawRemainingTimeNSecs_shim(timer) <= 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+// QThread sleep & timed wait method shims.
+//
+// While faking time, a sleep on the application's main thread fast-forwards time through the sleep period (generating timeouts along
+// the way) rather than blocking.  Sleeps on other threads, and timed waits on any thread, block until satisfied or until their domain's
+// time reaches the end of the sleep/wait period, which happens as the main thread (or test code) moves time on, or by itself once every
+// participating thread is blocked if auto-advance is enabled.
+//
+// Waits on real synchronisation primitives are made in short real time slices, so the waiting thread can keep an eye on faked time in
+// between.
+
+static constexpr unsigned long waitSliceMS = 1;
+
+static std::unique_lock<QMutex> lockClockControl(TimeDomain& domain);
+static bool nextTimerDue(TimeDomain& domain, qint64 limit, qint64& timeDue);
+static qint64 advanceFakedTime(TimeDomain& domain, qint64 endTime, const std::function<bool(void)>& until = nullptr);
+
+// Blocking wait on a real synchronisation primitive
+class TimedWait
+{
+public:
+    virtual ~TimedWait() {}
+
+    // Wait up to <realMS> of real time, returning true if primitive was acquired/signalled
+    virtual bool attempt(unsigned long realMS) = 0;
+
+    // Release any lock held by waiter while it moves time on, and reacquire it afterwards, returning true if the wait was satisfied
+    // in the meantime
+    virtual void release(void) {}
+    virtual bool reacquire(void)   {return false;}
+
+    // Whether an unsuccessful attempt was final (wait failing for reasons other than timing out), so there's no point waiting on
+    virtual bool abandoned(void) const     {return false;}
+};
+
+// Wait conditions whose waiters have temporarily released their mutex, along with number of wakeOne()/wakeAll() calls on them since.
+// Guarded by <releasedConditionsMutex>, <releasedConditionCount> allowing wakeOne()/wakeAll() to skip the lock when there are none.
+struct ReleasedCondition
+{
+    int     waiters = 0;
+    quint64 wakes   = 0;
+};
+
+static std::mutex releasedConditionsMutex;
+static std::unordered_map<const QWaitCondition*, ReleasedCondition> releasedConditions;
+static std::atomic<int> releasedConditionCount(0);
+
+class ConditionWait: public TimedWait
+{
+public:
+    ConditionWait(QWaitCondition* condition, QMutex* mutex)
+        : condition(condition), mutex(mutex) {}
+
+    bool attempt(unsigned long realMS) override
+    {
+        return pQt5Core_QWaitCondition_wait(condition, mutex, realMS);
+    }
+
+    void release(void) override
+    {
+        {
+            std::lock_guard<std::mutex> lock(releasedConditionsMutex);
+
+            ReleasedCondition& released = releasedConditions[condition];
+
+            ++released.waiters;
+            wakesAtRelease = released.wakes;
+
+            ++releasedConditionCount;
+        }
+
+        mutex->unlock();
+    }
+
+    bool reacquire(void) override
+    {
+        mutex->lock();
+
+        std::lock_guard<std::mutex> lock(releasedConditionsMutex);
+
+        auto ii = releasedConditions.find(condition);
+
+        assert(ii != releasedConditions.end());
+
+        // Treat any wake while mutex was released as having been meant for this waiter, as it would have been waiting
+        bool woken = (ii->second.wakes != wakesAtRelease);
+
+        if (--ii->second.waiters == 0)
+        {
+            releasedConditions.erase(ii);
+        }
+
+        --releasedConditionCount;
+
+        return woken;
+    }
+
+private:
+    QWaitCondition* condition;
+    QMutex*         mutex;
+    quint64         wakesAtRelease = 0;
+};
+
+class SemaphoreWait: public TimedWait
+{
+public:
+    SemaphoreWait(QSemaphore* semaphore, int n)
+        : semaphore(semaphore), n(n) {}
+
+    bool attempt(unsigned long realMS) override
+    {
+        return pQt5Core_QSemaphore_tryAcquire(semaphore, n, static_cast<int>(realMS));
+    }
+
+private:
+    QSemaphore* semaphore;
+    int         n;
+};
+
+class MutexWait: public TimedWait
+{
+public:
+    explicit MutexWait(QMutex* mutex)
+        : mutex(mutex) {}
+
+    bool attempt(unsigned long realMS) override
+    {
+        return pQt5Core_QMutex_tryLock(mutex, static_cast<int>(realMS));
+    }
+
+private:
+    QMutex* mutex;
+};
+
+class ThreadWait: public TimedWait
+{
+public:
+    explicit ThreadWait(QThread* thread)
+        : thread(thread) {}
+
+    bool attempt(unsigned long realMS) override
+    {
+        return pQt5Core_QThread_wait(thread, realMS);
+    }
+
+private:
+    QThread* thread;
+};
+
+class ThreadPoolWait: public TimedWait
+{
+public:
+    explicit ThreadPoolWait(QThreadPool* pool)
+        : pool(pool) {}
+
+    bool attempt(unsigned long realMS) override
+    {
+        return pQt5Core_QThreadPool_waitForDone(pool, static_cast<int>(realMS));
+    }
+
+private:
+    QThreadPool* pool;
+};
+
+static bool isApplicationThread(void)
+{
+    QCoreApplication* application = QCoreApplication::instance();
+
+    return (application != nullptr) && (application->thread() == QThread::currentThread());
+}
+
+// Domain calling thread is counted as participating in, and that domain's participation generation at the time
+struct Participation
+{
+    TimeDomain* domain      = nullptr;
+    quint64     generation  = 0;
+
+    ~Participation()
+    {
+        if (domain != nullptr)
+        {
+            std::lock_guard<QMutex> lock(domain->sleepersMutex);
+
+            if (generation == domain->participationGeneration)
+            {
+                --domain->participants;
+            }
+        }
+    }
+};
+
+static thread_local Participation participation;
+
+static void renewParticipation(TimeDomain& domain)
+{
+    // Count calling thread, already participating in <domain>, again should domain's participation have been reset since (with
+    // <sleepersMutex> held)
+    if (participation.generation != domain.participationGeneration)
+    {
+        ++domain.participants;
+
+        participation.generation = domain.participationGeneration;
+    }
+}
+
+static void participate(TimeDomain& domain)
+{
+    // Count calling thread as participating in <domain> until it exits, next blocks in another domain, or domain's participation is
+    // reset
+    if (participation.domain != &domain)
+    {
+        if (participation.domain != nullptr)
+        {
+            std::lock_guard<QMutex> lock(participation.domain->sleepersMutex);
+
+            if (participation.generation == participation.domain->participationGeneration)
+            {
+                --participation.domain->participants;
+            }
+        }
+
+        std::lock_guard<QMutex> lock(domain.sleepersMutex);
+
+        ++domain.participants;
+
+        participation.domain        = &domain;
+        participation.generation    = domain.participationGeneration;
+    }
+}
+
+static void resetParticipation(TimeDomain& domain)
+{
+    // Forget threads that have blocked in <domain> so far.  Those still blocked are counted again within a wait slice, as they renew
+    // their participation.
+    std::lock_guard<QMutex> lock(domain.sleepersMutex);
+
+    domain.participants = 0;
+
+    ++domain.participationGeneration;
+}
+
+static bool autoAdvanceFakedTime(TimeDomain& domain, qint64 wakeTime)
+{
+    // Move <domain>'s faked time on until its monotonic clock reaches <wakeTime>, or to the next timer due if sooner (so that anything
+    // that timer's timeout wakes gets its chance to run before time moves on any further)
+    auto lock = lockClockControl(domain);
+
+    qint64 timeNow = domain.fakedNSSinceEpoch;
+
+    if (timeNow == -1)
+    {
+        return false;
+    }
+
+    qint64 endTime;
+
+    if ((wakeTime == std::numeric_limits<qint64>::max()) ||
+        __builtin_add_overflow(timeNow, qMax<qint64>(0, wakeTime - currentMonotonicTime(domain)), &endTime))
+    {
+        endTime = std::numeric_limits<qint64>::max();
+    }
+
+    qint64 timeDue;
+
+    if (nextTimerDue(domain, endTime, timeDue))
+    {
+        endTime = timeDue;
+    }
+
+    if (endTime == std::numeric_limits<qint64>::max())
+    {
+        // Every thread waiting forever, with no timer due to wake any of them
+        return false;
+    }
+
+    qint64 realStartNS = monotonicTime();
+
+    ++fastForwardDepth;
+
+    endTime = advanceFakedTime(domain, endTime);
+
+    --fastForwardDepth;
+
+    countFastForward(endTime - timeNow, realStartNS);
+
+    return true;
+}
+
+static bool virtualWait(TimeDomain& domain, qint64 wakeTime, TimedWait* wait)
+{
+    // Block calling thread until <wait> is satisfied or <domain>'s monotonic clock reaches <wakeTime> (max. qint64 value to wait
+    // forever), returning true in the former case.  Without a <wait> simply sleeps until <wakeTime>.
+    participate(domain);
+
+    TimerShard* shard;
+
+    {
+        QReadLocker shardsLock(&domain.timerShardsLock);
+        shard = findTimerShard(domain, QThread::currentThread());
+    }
+
+    if (shard != nullptr)
+    {
+        shard->parked = true;
+    }
+
+    // Unless frozen, time is also taken to pass at domain's rate while blocked, so waits still time out should nothing else be moving
+    // time on (as when it's the main thread that's blocked)
+    qint64 startTime        = currentMonotonicTime(domain);
+    qint64 realStartTime    = monotonicTime();
+
+    std::unique_lock<QMutex> lock(domain.sleepersMutex);
+
+    auto wakeTimeEntry = domain.wakeTimes.insert(wakeTime);
+
+    ++domain.sleepers;
+    ++domain.blockedGeneration;
+
+    // Generation at which every participating thread was last seen blocked, 0 if not
+    quint64 quiescentGeneration = 0;
+
+    bool satisfied = false;
+
+    while (true)
+    {
+        renewParticipation(domain);
+
+        qint64 timeNow = currentMonotonicTime(domain);
+
+        if (wait != nullptr)
+        {
+            // Final attempt once wait has timed out is made without waiting
+            lock.unlock();
+            satisfied = wait->attempt((timeNow >= wakeTime) ? 0 : waitSliceMS);
+            lock.lock();
+
+            if (satisfied || wait->abandoned())
+            {
+                break;
+            }
+
+            timeNow = currentMonotonicTime(domain);
+        }
+
+        if ((timeNow >= wakeTime) ||
+            (!domain.frozen && (wakeTime - startTime <= (monotonicTime() - realStartTime) * domain.rate.load())))
+        {
+            break;
+        }
+
+        if ((domain.fakedNSSinceEpoch == -1) && (wait == nullptr))
+        {
+            // Domain has returned to real time, sleep out remainder in real time
+            lock.unlock();
+
+            realSleep(wakeTime - timeNow);
+
+            lock.lock();
+            break;
+        }
+
+        if (domain.autoAdvance && !domain.advancing && (domain.fakedNSSinceEpoch != -1) &&
+            (domain.wakeTimes.size() == static_cast<size_t>(domain.participants)))
+        {
+            // Every participating thread is blocked.  Once that has held for a whole slice, so any thread just woken has had its chance
+            // to run, move time on to the earliest point one of them is due to wake.
+            if (quiescentGeneration != domain.blockedGeneration)
+            {
+                quiescentGeneration = domain.blockedGeneration;
+            }
+            else
+            {
+                qint64 earliestWakeTime = *domain.wakeTimes.begin();
+
+                domain.advancing = true;
+                lock.unlock();
+
+                if (wait != nullptr)
+                {
+                    wait->release();
+                }
+
+                bool advanced = autoAdvanceFakedTime(domain, earliestWakeTime);
+
+                if (wait != nullptr)
+                {
+                    satisfied = wait->reacquire();
+                }
+
+                lock.lock();
+                domain.advancing = false;
+
+                if (satisfied)
+                {
+                    break;
+                }
+
+                if (advanced)
+                {
+                    quiescentGeneration = 0;
+                    ++domain.blockedGeneration;
+                }
+            }
+        }
+        else
+        {
+            quiescentGeneration = 0;
+        }
+
+        if (wait == nullptr)
+        {
+            pQt5Core_QWaitCondition_wait(&domain.timeMoved, &domain.sleepersMutex, waitSliceMS);
+        }
+
+        if ((shard != nullptr) && (shard->pendingBatches > 0))
+        {
+            // Generate timeouts for any batch of this thread's timers posted before it parked, which another thread will be waiting on
+            // before it can move time on
+            lock.unlock();
+
+            if (wait != nullptr)
+            {
+                wait->release();
+            }
+
+            QCoreApplication::sendPostedEvents(nullptr, TimeoutBatchEvent::eventType());
+
+            if (wait != nullptr)
+            {
+                satisfied = wait->reacquire();
+            }
+
+            lock.lock();
+
+            if (satisfied)
+            {
+                break;
+            }
+        }
+    }
+
+    domain.wakeTimes.erase(wakeTimeEntry);
+
+    --domain.sleepers;
+    ++domain.blockedGeneration;
+
+    lock.unlock();
+
+    if (shard != nullptr)
+    {
+        // Timers held back while parked may now be overdue, have them generated promptly
+        shard->parked = false;
+
+        requestIdleTimerRearm(std::numeric_limits<qint64>::min());
+    }
+
+    return satisfied;
+}
+
+static void notifySleepers(TimeDomain& domain)
+{
+    if (domain.sleepers > 0)
+    {
+        std::lock_guard<QMutex> lock(domain.sleepersMutex);
+
+        pQt5Core_QWaitCondition_wakeAll(&domain.timeMoved);
+    }
+}
+
+static qint64 waitDeadline(const TimeDomain& domain, qint64 msecs)
+{
+    // Deadline on <domain>'s monotonic clock for a wait of <msecs> (forever if negative)
+    qint64 deadline;
+
+    if ((msecs < 0) || __builtin_add_overflow(currentMonotonicTime(domain), msecs * nsPerMS, &deadline))
+    {
+        return std::numeric_limits<qint64>::max();
+    }
+
+    return deadline;
+}
+
+static qint64 waitDeadline(const QDeadlineTimer& deadline)
+{
+    return deadline.isForever() ? std::numeric_limits<qint64>::max() : deadlineTimerNS(&deadline);
+}
+
+static unsigned long remainingWaitMS(const TimeDomain& domain, const QDeadlineTimer& deadline)
+{
+    // Time remaining until <deadline> for real wait, ULONG_MAX if forever
+    if (deadline.isForever())
+    {
+        return std::numeric_limits<unsigned long>::max();
+    }
+
+    qint64 remaining = deadlineTimerNS(&deadline) - currentMonotonicTime(domain);
+
+    return (remaining <= 0) ? 0 : static_cast<unsigned long>((remaining + nsPerMS - 1) / nsPerMS);
+}
+
+static qint64 waitMS(unsigned long time)
+{
+    // Wait time in mS, -1 if forever
+    return (time == std::numeric_limits<unsigned long>::max()) ? -1 : static_cast<qint64>(qMin<unsigned long>(time, std::numeric_limits<int>::max()));
+}
+
+inline static void QThread_sleep_shim(std::chrono::nanoseconds duration, void (* realSleep)(unsigned long), unsigned long realDuration)
+{
+    TimeDomain& domain = callingThreadTimeDomain();
+
+    if (domain.fakedNSSinceEpoch == -1)
+    {
+        assert(realSleep != nullptr);
+        realSleep(realDuration);
+    }
+    else if (isApplicationThread())
+    {
+        fastForward(&domain, duration);
+    }
+    else
+    {
+        virtualWait(domain, currentMonotonicTime(domain) + duration.count(), nullptr);
+    }
+}
+
+inline static bool QThread_wait_shim(QThread* thread, unsigned long time)
+{
+    TimeDomain& domain = callingThreadTimeDomain();
+
+    if ((domain.fakedNSSinceEpoch == -1) || (time == 0))
+    {
+        return pQt5Core_QThread_wait(thread, time);
+    }
+
+    ThreadWait wait(thread);
+
+    return virtualWait(domain, waitDeadline(domain, waitMS(time)), &wait);
+}
+
+inline static bool QThread_wait_shim(QThread* thread, QDeadlineTimer deadline)
+{
+    TimeDomain& domain = callingThreadTimeDomain();
+
+    if (domain.fakedNSSinceEpoch == -1)
+    {
+        return pQt5Core_QThread_wait(thread, remainingWaitMS(domain, deadline));
+    }
+
+    ThreadWait wait(thread);
+
+    return virtualWait(domain, waitDeadline(deadline), &wait);
+}
+
+inline static bool QWaitCondition_wait_shim(QWaitCondition* condition, QMutex* mutex, unsigned long time)
+{
+    TimeDomain& domain = callingThreadTimeDomain();
+
+    if ((domain.fakedNSSinceEpoch == -1) || (time == 0))
+    {
+        return pQt5Core_QWaitCondition_wait(condition, mutex, time);
+    }
+
+    ConditionWait wait(condition, mutex);
+
+    return virtualWait(domain, waitDeadline(domain, waitMS(time)), &wait);
+}
+
+inline static bool QWaitCondition_wait_shim(QWaitCondition* condition, QMutex* mutex, QDeadlineTimer deadline)
+{
+    TimeDomain& domain = callingThreadTimeDomain();
+
+    if (domain.fakedNSSinceEpoch == -1)
+    {
+        return pQt5Core_QWaitCondition_wait(condition, mutex, remainingWaitMS(domain, deadline));
+    }
+
+    ConditionWait wait(condition, mutex);
+
+    return virtualWait(domain, waitDeadline(deadline), &wait);
+}
+
+inline static void QWaitCondition_wake_shim(QWaitCondition* condition, void (* realWake)(QWaitCondition*))
+{
+    realWake(condition);
+
+    if (releasedConditionCount > 0)
+    {
+        std::lock_guard<std::mutex> lock(releasedConditionsMutex);
+
+        auto ii = releasedConditions.find(condition);
+
+        if (ii != releasedConditions.end())
+        {
+            ++ii->second.wakes;
+        }
+    }
+}
+
+inline static bool QSemaphore_tryAcquire_shim(QSemaphore* semaphore, int n, int timeout)
+{
+    TimeDomain& domain = callingThreadTimeDomain();
+
+    if ((domain.fakedNSSinceEpoch == -1) || (timeout == 0))
+    {
+        return pQt5Core_QSemaphore_tryAcquire(semaphore, n, timeout);
+    }
+
+    SemaphoreWait wait(semaphore, n);
+
+    return virtualWait(domain, waitDeadline(domain, timeout), &wait);
+}
+
+inline static bool QMutex_tryLock_shim(QMutex* mutex, int timeout)
+{
+    TimeDomain& domain = callingThreadTimeDomain();
+
+    if ((domain.fakedNSSinceEpoch == -1) || (timeout == 0))
+    {
+        return pQt5Core_QMutex_tryLock(mutex, timeout);
+    }
+
+    MutexWait wait(mutex);
+
+    return virtualWait(domain, waitDeadline(domain, timeout), &wait);
+}
+
+inline static bool QThreadPool_waitForDone_shim(QThreadPool* pool, int msecs)
+{
+    TimeDomain& domain = callingThreadTimeDomain();
+
+    if ((domain.fakedNSSinceEpoch == -1) || (msecs == 0))
+    {
+        return pQt5Core_QThreadPool_waitForDone(pool, msecs);
+    }
+
+    ThreadPoolWait wait(pool);
+
+    return virtualWait(domain, waitDeadline(domain, msecs), &wait);
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+// QProcess & QtNetwork waitFor* method shims.
+//
+// While faking time these wait in short real time slices too, timing out on faked time, so I/O that completes early still returns as
+// soon as it does.  QProcess (and server) waits can simply be made in slices, as their timing out has no side effects beyond setting
+// error state.  Socket waits however report a timeout via. errorOccurred(), so the socket's descriptor is polled for readiness instead,
+// with Qt only left to deal with the socket once it's ready.
+//
+// NOTE: QProcess::waitForReadyRead/waitForBytesWritten() & the QAbstractSocket/QLocalSocket waits overriding QIODevice virtual methods
+// are only intercepted when called directly, not when dispatched via. the vtable (e.g. through a QIODevice pointer).
+
+// QAbstractSocket or QLocalSocket methods, both classes sharing the same values for the socket states of interest
+struct SocketFunctions
+{
+    static constexpr int unconnectedState   = 0;
+    static constexpr int connectingState    = 2;
+
+    const RealFunction<qintptr (*)(const QIODevice*)>&  socketDescriptor;
+    const RealFunction<int (*)(const QIODevice*)>&      state;
+    const RealFunction<bool (*)(QIODevice*, int)>&      waitForConnected;
+    const RealFunction<bool (*)(QIODevice*, int)>&      waitForReadyRead;
+    const RealFunction<bool (*)(QIODevice*, int)>&      waitForBytesWritten;
+    const RealFunction<bool (*)(QIODevice*, int)>&      waitForDisconnected;
+};
+
+static const SocketFunctions abstractSocketFunctions{pQt5Network_QAbstractSocket_socketDescriptor,
+                                                     pQt5Network_QAbstractSocket_state,
+                                                     pQt5Network_QAbstractSocket_waitForConnected,
+                                                     pQt5Network_QAbstractSocket_waitForReadyRead,
+                                                     pQt5Network_QAbstractSocket_waitForBytesWritten,
+                                                     pQt5Network_QAbstractSocket_waitForDisconnected};
+
+static const SocketFunctions localSocketFunctions{pQt5Network_QLocalSocket_socketDescriptor,
+                                                  pQt5Network_QLocalSocket_state,
+                                                  pQt5Network_QLocalSocket_waitForConnected,
+                                                  pQt5Network_QLocalSocket_waitForReadyRead,
+                                                  pQt5Network_QLocalSocket_waitForBytesWritten,
+                                                  pQt5Network_QLocalSocket_waitForDisconnected};
+
+class ProcessWait: public TimedWait
+{
+public:
+    ProcessWait(QProcess* process, bool (* realWait)(QProcess*, int))
+        : process(process), realWait(realWait) {}
+
+    bool attempt(unsigned long realMS) override
+    {
+        return realWait(process, static_cast<int>(realMS));
+    }
+
+    bool abandoned(void) const override
+    {
+        // Anything other than a timeout (process failing to start, exiting before becoming ready etc.) is final
+        return (process->state() == QProcess::NotRunning) || (process->error() != QProcess::Timedout);
+    }
+
+private:
+    QProcess*   process;
+    bool        (* realWait)(QProcess*, int);
+};
+
+class SocketWait: public TimedWait
+{
+public:
+    enum class Condition
+    {
+        Connected,
+        ReadyRead,
+        BytesWritten,
+        Disconnected
+    };
+
+    SocketWait(QIODevice* socket, const SocketFunctions& functions, Condition condition)
+        : socket(socket), functions(functions), condition(condition) {}
+
+    bool attempt(unsigned long realMS) override
+    {
+        qintptr descriptor = functions.socketDescriptor(socket);
+
+        if (descriptor == -1)
+        {
+            // Socket closed
+            done = true;
+            return false;
+        }
+
+        struct pollfd pfd;
+
+        pfd.fd      = static_cast<int>(descriptor);
+        pfd.events  = ((condition == Condition::ReadyRead) || (condition == Condition::Disconnected)) ? POLLIN : POLLOUT;
+        pfd.revents = 0;
+
+        if (realPoll(&pfd, 1, static_cast<int>(realMS)) <= 0)
+        {
+            return false;
+        }
+
+        // Socket is ready (or has failed), so Qt's own wait returns without timing out
+        switch (condition)
+        {
+            case Condition::Connected:
+                done = true;
+                return functions.waitForConnected(socket, waitSliceMS);
+
+            case Condition::ReadyRead:
+                done = true;
+                return functions.waitForReadyRead(socket, waitSliceMS);
+
+            case Condition::BytesWritten:
+                done = true;
+                return functions.waitForBytesWritten(socket, waitSliceMS);
+
+            case Condition::Disconnected:
+                // Read whatever has arrived, which disconnects socket if it's been closed at the far end
+                functions.waitForReadyRead(socket, waitSliceMS);
+                return functions.state(socket) == SocketFunctions::unconnectedState;
+        }
+
+        return false;
+    }
+
+    bool abandoned(void) const override
+    {
+        return done;
+    }
+
+private:
+    QIODevice*              socket;
+    const SocketFunctions&  functions;
+    const Condition         condition;
+    bool                    done = false;
+};
+
+class LocalSocketConnectWait: public TimedWait
+{
+public:
+    explicit LocalSocketConnectWait(QIODevice* socket)
+        : socket(socket) {}
+
+    bool attempt(unsigned long realMS) override
+    {
+        // Unlike other socket waits, QLocalSocket::waitForConnected() doesn't report its timing out
+        return localSocketFunctions.waitForConnected(socket, static_cast<int>(realMS));
+    }
+
+    bool abandoned(void) const override
+    {
+        return localSocketFunctions.state(socket) != SocketFunctions::connectingState;
+    }
+
+private:
+    QIODevice* socket;
+};
+
+class ServerWait: public TimedWait
+{
+public:
+    ServerWait(QObject* server, bool (* realWait)(QObject*, int, bool*))
+        : server(server), realWait(realWait) {}
+
+    bool attempt(unsigned long realMS) override
+    {
+        return realWait(server, static_cast<int>(realMS), &timedOut);
+    }
+
+    bool abandoned(void) const override
+    {
+        return !timedOut;
+    }
+
+private:
+    QObject*    server;
+    bool        (* realWait)(QObject*, int, bool*);
+    bool        timedOut = true;
+};
+
+inline static bool QProcess_waitFor_shim(QProcess* process, int msecs, bool (* realWait)(QProcess*, int))
+{
+    TimeDomain& domain = callingThreadTimeDomain();
+
+    if ((domain.fakedNSSinceEpoch == -1) || (msecs == 0) || (process->state() == QProcess::NotRunning))
+    {
+        return realWait(process, msecs);
+    }
+
+    ProcessWait wait(process, realWait);
+
+    return virtualWait(domain, waitDeadline(domain, msecs), &wait);
+}
+
+inline static bool QProcess_waitForBytesWritten_shim(QProcess* process, int msecs)
+{
+    if (process->bytesToWrite() == 0)
+    {
+        // Returns false straight away, without touching error state
+        return pQt5Core_QProcess_waitForBytesWritten(process, msecs);
+    }
+
+    return QProcess_waitFor_shim(process, msecs, pQt5Core_QProcess_waitForBytesWritten);
+}
+
+inline static bool QSocket_waitFor_shim(QIODevice* socket,
+                                        int msecs,
+                                        const SocketFunctions& functions,
+                                        SocketWait::Condition condition,
+                                        bool (* realWait)(QIODevice*, int))
+{
+    TimeDomain& domain = callingThreadTimeDomain();
+
+    // Sockets without a descriptor yet (looking up host, connecting local socket) are left to wait in real time
+    if ((domain.fakedNSSinceEpoch == -1) || (msecs == 0) || (functions.socketDescriptor(socket) == -1))
+    {
+        return realWait(socket, msecs);
+    }
+
+    SocketWait wait(socket, functions, condition);
+
+    return virtualWait(domain, waitDeadline(domain, msecs), &wait);
+}
+
+inline static bool QLocalSocket_waitForConnected_shim(QIODevice* socket, int msecs)
+{
+    TimeDomain& domain = callingThreadTimeDomain();
+
+    if ((domain.fakedNSSinceEpoch == -1) || (msecs == 0) ||
+        (localSocketFunctions.state(socket) != SocketFunctions::connectingState))
+    {
+        return localSocketFunctions.waitForConnected(socket, msecs);
+    }
+
+    LocalSocketConnectWait wait(socket);
+
+    return virtualWait(domain, waitDeadline(domain, msecs), &wait);
+}
+
+inline static bool QServer_waitForNewConnection_shim(QObject* server, int msec, bool* timedOut, bool (* realWait)(QObject*, int, bool*))
+{
+    TimeDomain& domain = callingThreadTimeDomain();
+
+    if ((domain.fakedNSSinceEpoch == -1) || (msec == 0))
+    {
+        return realWait(server, msec, timedOut);
+    }
+
+    ServerWait wait(server, realWait);
+
+    bool satisfied = virtualWait(domain, waitDeadline(domain, msec), &wait);
+
+    if (timedOut != nullptr)
+    {
+        *timedOut = !satisfied && !wait.abandoned();
+    }
+
+    return satisfied;
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+// libc clock function shims.
+//
+// Optional (see setFakeLibcClocks()), so code reading the clock other than via. Qt - std::chrono clocks, third party libraries etc. -
+// sees the calling thread's domain's faked time too.  CLOCK_REALTIME (and gettimeofday()/time()) follow faked current time, while
+// CLOCK_MONOTONIC follows the domain's monotonic clock, as QElapsedTimer & QDeadlineTimer do.  The raw & boot time clocks keep their
+// own base, shifted by however far the domain's monotonic clock has moved from the real one.
+//
+// Calls made from within libQt5Core.so itself are always left reading real time, as its event dispatcher, timed waits & so on time
+// their real waits with it, and the Qt methods that matter are shimmed above anyway.  Likewise calls from GLib, whose main loop
+// drives Qt's event dispatcher on most builds.
+
+static constexpr int fakeLibcRealtime   = 1;
+static constexpr int fakeLibcMonotonic  = 2;
+
+// Clocks currently being faked, a combination of the above.  While 0 the shims add just this one check to the real libc call.
+static std::atomic<int> fakedLibcClocks{0};
+
+// Address ranges of libQt5Core.so & GLib code, located by initialize()
+struct CodeRange
+{
+    uintptr_t start = 0;
+    uintptr_t end   = 0;
+};
+
+static CodeRange qtCoreCode;
+static CodeRange glibCode;
+
+inline static bool realTimeCaller(const void* caller)
+{
+    // Whether function was called from code always left seeing real time
+    uintptr_t callerAddress = reinterpret_cast<uintptr_t>(caller);
+
+    return ((callerAddress >= qtCoreCode.start) && (callerAddress < qtCoreCode.end)) ||
+           ((callerAddress >= glibCode.start) && (callerAddress < glibCode.end));
+}
+
+inline static bool libcClockFaked(int clock, const void* caller)
+{
+    return ((fakedLibcClocks.load(std::memory_order_relaxed) & clock) != 0) && !realTimeCaller(caller);
+}
+
+static TimeDomain* libcCallerTimeDomain(void)
+{
+    // Calling thread's domain, or nullptr if called while already looking it up
+    //
+    // Qt may itself read the clock while working out the calling thread's domain (e.g. on adopting a thread not started by Qt), which
+    // sees real time.  Domain lookup is avoided altogether while no thread has been bound to another domain.
+    thread_local bool looking = false;
+
+    if (looking)
+    {
+        return nullptr;
+    }
+
+    looking = true;
+
+    TimeDomain* domain = (timeDomainBindingsGeneration.load(std::memory_order_acquire) == 1) ? &defaultDomain : &callingThreadTimeDomain();
+
+    looking = false;
+
+    return domain;
+}
+
+static bool libcClockTime(int clock, qint64& ns)
+{
+    // Calling thread's domain's faked realtime, or monotonic clock time, returning false if domain isn't faking time
+    TimeDomain* domain = libcCallerTimeDomain();
+
+    if (domain == nullptr)
+    {
+        return false;
+    }
+
+    count(clockReadsCounter);
+
+    if (clock == fakeLibcRealtime)
+    {
+        ns = domain->fakedNSSinceEpoch.load(std::memory_order_acquire);
+
+        return ns != -1;
+    }
+
+    ns = currentMonotonicTime(*domain);
+
+    return true;
+}
+
+inline static int clock_gettime_shim(clockid_t clockId, struct timespec* ts, const void* caller)
+{
+    int clock;
+
+    switch (clockId)
+    {
+        case CLOCK_REALTIME:
+        case CLOCK_REALTIME_COARSE:
+            clock = fakeLibcRealtime;
+            break;
+
+        case CLOCK_MONOTONIC:
+        case CLOCK_MONOTONIC_COARSE:
+        case CLOCK_MONOTONIC_RAW:
+        case CLOCK_BOOTTIME:
+            clock = fakeLibcMonotonic;
+            break;
+
+        default:
+            clock = 0;
+            break;
+    }
+
+    qint64 ns;
+
+    if (!libcClockFaked(clock, caller) || (ts == nullptr) || !libcClockTime(clock, ns))
+    {
+        return realClockGettime(clockId, ts);
+    }
+
+    if ((clockId == CLOCK_MONOTONIC_RAW) || (clockId == CLOCK_BOOTTIME))
+    {
+        ns += realClockTime(clockId) - monotonicTime();
+    }
+
+    ts->tv_sec  = ns / 1000000000;
+    ts->tv_nsec = ns % 1000000000;
+
+    return 0;
+}
+
+inline static int gettimeofday_shim(struct timeval* tv, void* tz, const void* caller)
+{
+    int result = pLibc_gettimeofday(tv, tz);
+
+    qint64 ns;
+
+    if ((result == 0) && (tv != nullptr) && libcClockFaked(fakeLibcRealtime, caller) && libcClockTime(fakeLibcRealtime, ns))
+    {
+        tv->tv_sec  = ns / 1000000000;
+        tv->tv_usec = ns % 1000000000 / 1000;
+    }
+
+    return result;
+}
+
+inline static time_t time_shim(time_t* t, const void* caller)
+{
+    qint64 ns;
+
+    if (!libcClockFaked(fakeLibcRealtime, caller) || !libcClockTime(fakeLibcRealtime, ns))
+    {
+        return pLibc_time(t);
+    }
+
+    time_t seconds = ns / 1000000000;
+
+    if (t != nullptr)
+    {
+        *t = seconds;
+    }
+
+    return seconds;
+}
+
+static int findRealTimeCode(struct dl_phdr_info* info, size_t, void*)
+{
+    // dl_iterate_phdr() callback, noting the executable segments of libQt5Core (whichever object holds its QTimer::start()) & GLib
+    uintptr_t qtCoreFunction = reinterpret_cast<uintptr_t>(static_cast<void (*)(QTimer*)>(pQt5Core_QTimer_start));
+    bool glib = (info->dlpi_name != nullptr) && (strstr(info->dlpi_name, "libglib-2.0.so") != nullptr);
+
+    for (int i = 0; i < info->dlpi_phnum; ++i)
+    {
+        const ElfW(Phdr)& header = info->dlpi_phdr[i];
+
+        if ((header.p_type == PT_LOAD) && ((header.p_flags & PF_X) != 0))
+        {
+            CodeRange code;
+
+            code.start  = info->dlpi_addr + header.p_vaddr;
+            code.end    = code.start + header.p_memsz;
+
+            if ((qtCoreFunction >= code.start) && (qtCoreFunction < code.end))
+            {
+                qtCoreCode = code;
+            }
+            else if (glib)
+            {
+                glibCode = code;
+            }
+        }
+    }
+
+    return 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+// libc sleep & timed wait function shims.
+//
+// Optional (see setFakeLibcWaits()), so sleeps & timed waits made other than via. Qt - std::this_thread::sleep_for(),
+// std::condition_variable, poll loops in third party libraries etc. - run on faked time just as the QThread sleep & timed wait shims
+// above do.  Pure sleeps (including poll()/select() on no descriptors) fast-forward faked time on the application's main thread and
+// block on faked time on other threads, while waits block until ready or until faked time reaches their timeout.
+//
+// Absolute deadlines are read against the clock as the caller sees it, so are on faked time if libc clocks are also being faked.
+// pthread_cond_timedwait() deadlines are taken to be on CLOCK_REALTIME (the default for condition variables), as the clock a
+// condition variable was created with can't be queried.  Calls from libQt5Core.so & GLib are left alone, as for the clock shims.
+
+static std::atomic<bool> fakedLibcWaits{false};
+
+static TimeDomain* libcWaitTimeDomain(const void* caller)
+{
+    // Calling thread's domain if its libc sleeps & waits are to run on faked time, otherwise nullptr
+    if (!fakedLibcWaits.load(std::memory_order_relaxed) || realTimeCaller(caller))
+    {
+        return nullptr;
+    }
+
+    TimeDomain* domain = libcCallerTimeDomain();
+
+    return ((domain != nullptr) && (domain->fakedNSSinceEpoch != -1)) ? domain : nullptr;
+}
+
+static void libcSleep(TimeDomain& domain, qint64 ns)
+{
+    if (isApplicationThread())
+    {
+        fastForward(&domain, std::chrono::nanoseconds(ns));
+    }
+    else
+    {
+        virtualWait(domain, currentMonotonicTime(domain) + ns, nullptr);
+    }
+}
+
+inline static bool validTimespec(const struct timespec* ts)
+{
+    return (ts != nullptr) && (ts->tv_sec >= 0) && (ts->tv_nsec >= 0) && (ts->tv_nsec < 1000000000);
+}
+
+static qint64 timespecNS(const struct timespec& ts)
+{
+    return static_cast<qint64>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+static qint64 libcTimeUntil(clockid_t clockId, const struct timespec& deadline, const void* caller)
+{
+    // Time (nS) until absolute <deadline> on <clockId>, as clock is seen by caller
+    struct timespec now;
+
+    clock_gettime_shim(clockId, &now, caller);
+
+    return std::max<qint64>(timespecNS(deadline) - timespecNS(now), 0);
+}
+
+class PollWait: public TimedWait
+{
+public:
+    PollWait(struct pollfd* fds, nfds_t nfds)
+        : fds(fds), nfds(nfds) {}
+
+    bool attempt(unsigned long realMS) override
+    {
+        pollResult  = realPoll(fds, nfds, static_cast<int>(realMS));
+        pollError   = errno;
+
+        return pollResult != 0;
+    }
+
+    // Result of final attempt, restoring its errno
+    int result(void) const
+    {
+        errno = pollError;
+        return pollResult;
+    }
+
+private:
+    struct pollfd*  fds;
+    nfds_t          nfds;
+    int             pollResult  = 0;
+    int             pollError   = 0;
+};
+
+class EpollWait: public TimedWait
+{
+public:
+    EpollWait(int epfd, struct epoll_event* events, int maxEvents)
+        : epfd(epfd), events(events), maxEvents(maxEvents) {}
+
+    bool attempt(unsigned long realMS) override
+    {
+        waitResult  = pLibc_epoll_wait(epfd, events, maxEvents, static_cast<int>(realMS));
+        waitError   = errno;
+
+        return waitResult != 0;
+    }
+
+    int result(void) const
+    {
+        errno = waitError;
+        return waitResult;
+    }
+
+private:
+    int                 epfd;
+    struct epoll_event* events;
+    int                 maxEvents;
+    int                 waitResult  = 0;
+    int                 waitError   = 0;
+};
+
+class SelectWait: public TimedWait
+{
+public:
+    SelectWait(int nfds, fd_set* readFds, fd_set* writeFds, fd_set* exceptFds)
+        : nfds(nfds), sets{readFds, writeFds, exceptFds}
+    {
+        // select() overwrites the sets it's passed, so every attempt starts over from those originally requested
+        for (int set = 0; set < 3; ++set)
+        {
+            if (sets[set] != nullptr)
+            {
+                requested[set] = *sets[set];
+            }
+        }
+    }
+
+    bool attempt(unsigned long realMS) override
+    {
+        for (int set = 0; set < 3; ++set)
+        {
+            if (sets[set] != nullptr)
+            {
+                *sets[set] = requested[set];
+            }
+        }
+
+        struct timeval timeout;
+
+        timeout.tv_sec  = realMS / 1000;
+        timeout.tv_usec = realMS % 1000 * 1000;
+
+        selectResult    = pLibc_select(nfds, sets[0], sets[1], sets[2], &timeout);
+        selectError     = errno;
+
+        return selectResult != 0;
+    }
+
+    int result(void) const
+    {
+        errno = selectError;
+        return selectResult;
+    }
+
+private:
+    int     nfds;
+    fd_set* sets[3];
+    fd_set  requested[3];
+    int     selectResult    = 0;
+    int     selectError     = 0;
+};
+
+class PthreadConditionWait: public TimedWait
+{
+public:
+    PthreadConditionWait(pthread_cond_t* condition, pthread_mutex_t* mutex)
+        : condition(condition), mutex(mutex) {}
+
+    bool attempt(unsigned long realMS) override
+    {
+        // Real deadline on the monotonic clock, whichever clock condition was created with
+        qint64 ns = monotonicTime() + static_cast<qint64>(realMS) * nsPerMS;
+
+        struct timespec deadline;
+
+        deadline.tv_sec     = ns / 1000000000;
+        deadline.tv_nsec    = ns % 1000000000;
+
+        waitResult = pLibc_pthread_cond_clockwait(condition, mutex, CLOCK_MONOTONIC, &deadline);
+
+        return waitResult != ETIMEDOUT;
+    }
+
+    void release(void) override
+    {
+        pthread_mutex_unlock(mutex);
+    }
+
+    bool reacquire(void) override
+    {
+        pthread_mutex_lock(mutex);
+
+        // A signal while mutex was released can't be told apart from none, so report a (permitted) spurious wake-up rather than risk
+        // missing it
+        waitResult = 0;
+
+        return true;
+    }
+
+    int result(void) const
+    {
+        return waitResult;
+    }
+
+private:
+    pthread_cond_t*     condition;
+    pthread_mutex_t*    mutex;
+    int                 waitResult = ETIMEDOUT;
+};
+
+inline static int nanosleep_shim(const struct timespec* duration, struct timespec* remaining, const void* caller)
+{
+    TimeDomain* domain = libcWaitTimeDomain(caller);
+
+    if ((domain == nullptr) || !validTimespec(duration))
+    {
+        return pLibc_nanosleep(duration, remaining);
+    }
+
+    libcSleep(*domain, timespecNS(*duration));
+
+    return 0;
+}
+
+inline static int clock_nanosleep_shim(clockid_t clockId, int flags, const struct timespec* request, struct timespec* remaining,
+                                       const void* caller)
+{
+    TimeDomain* domain = libcWaitTimeDomain(caller);
+
+    if ((domain == nullptr) || !validTimespec(request) || ((clockId != CLOCK_REALTIME) && (clockId != CLOCK_MONOTONIC)))
+    {
+        return pLibc_clock_nanosleep(clockId, flags, request, remaining);
+    }
+
+    libcSleep(*domain, ((flags & TIMER_ABSTIME) != 0) ? libcTimeUntil(clockId, *request, caller) : timespecNS(*request));
+
+    return 0;
+}
+
+inline static int usleep_shim(useconds_t usecs, const void* caller)
+{
+    TimeDomain* domain = libcWaitTimeDomain(caller);
+
+    if (domain == nullptr)
+    {
+        return pLibc_usleep(usecs);
+    }
+
+    libcSleep(*domain, static_cast<qint64>(usecs) * 1000);
+
+    return 0;
+}
+
+inline static unsigned int sleep_shim(unsigned int secs, const void* caller)
+{
+    TimeDomain* domain = libcWaitTimeDomain(caller);
+
+    if (domain == nullptr)
+    {
+        return pLibc_sleep(secs);
+    }
+
+    libcSleep(*domain, static_cast<qint64>(secs) * 1000000000);
+
+    return 0;
+}
+
+inline static int poll_shim(struct pollfd* fds, nfds_t nfds, int timeout, const void* caller)
+{
+    // Non-blocking polls & those without timeout are left as-is
+    TimeDomain* domain = (timeout > 0) ? libcWaitTimeDomain(caller) : nullptr;
+
+    if (domain == nullptr)
+    {
+        return realPoll(fds, nfds, timeout);
+    }
+
+    if (nfds == 0)
+    {
+        libcSleep(*domain, timeout * nsPerMS);
+        return 0;
+    }
+
+    PollWait wait(fds, nfds);
+
+    virtualWait(*domain, currentMonotonicTime(*domain) + timeout * nsPerMS, &wait);
+
+    return wait.result();
+}
+
+inline static int epoll_wait_shim(int epfd, struct epoll_event* events, int maxEvents, int timeout, const void* caller)
+{
+    TimeDomain* domain = (timeout > 0) ? libcWaitTimeDomain(caller) : nullptr;
+
+    if (domain == nullptr)
+    {
+        return pLibc_epoll_wait(epfd, events, maxEvents, timeout);
+    }
+
+    EpollWait wait(epfd, events, maxEvents);
+
+    virtualWait(*domain, currentMonotonicTime(*domain) + timeout * nsPerMS, &wait);
+
+    return wait.result();
+}
+
+inline static int select_shim(int nfds, fd_set* readFds, fd_set* writeFds, fd_set* exceptFds, struct timeval* timeout,
+                              const void* caller)
+{
+    bool timed = (timeout != nullptr) && (timeout->tv_sec >= 0) && (timeout->tv_usec >= 0) && ((timeout->tv_sec > 0) || (timeout->tv_usec > 0));
+
+    TimeDomain* domain = timed ? libcWaitTimeDomain(caller) : nullptr;
+
+    if (domain == nullptr)
+    {
+        return pLibc_select(nfds, readFds, writeFds, exceptFds, timeout);
+    }
+
+    qint64 ns = (static_cast<qint64>(timeout->tv_sec) * 1000000 + timeout->tv_usec) * 1000;
+
+    if ((nfds == 0) || ((readFds == nullptr) && (writeFds == nullptr) && (exceptFds == nullptr)))
+    {
+        libcSleep(*domain, ns);
+    }
+    else
+    {
+        SelectWait wait(nfds, readFds, writeFds, exceptFds);
+
+        if (virtualWait(*domain, currentMonotonicTime(*domain) + ns, &wait))
+        {
+            return wait.result();
+        }
+    }
+
+    // Timed out, with no time left (as Linux reports it)
+    timeout->tv_sec     = 0;
+    timeout->tv_usec    = 0;
+
+    return 0;
+}
+
+static bool pthreadConditionWait(pthread_cond_t* condition, pthread_mutex_t* mutex, clockid_t clockId, const struct timespec* deadline,
+                                 const void* caller, int& result)
+{
+    // Wait on <condition> until absolute <deadline> on faked time, returning false if not faking calling thread's waits
+    TimeDomain* domain = validTimespec(deadline) ? libcWaitTimeDomain(caller) : nullptr;
+
+    if (domain == nullptr)
+    {
+        return false;
+    }
+
+    PthreadConditionWait wait(condition, mutex);
+
+    virtualWait(*domain, currentMonotonicTime(*domain) + libcTimeUntil(clockId, *deadline, caller), &wait);
+
+    result = wait.result();
+
+    return true;
+}
+
+inline static int pthread_cond_timedwait_shim(pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* deadline,
+                                              const void* caller)
+{
+    int result;
+
+    if (!pthreadConditionWait(condition, mutex, CLOCK_REALTIME, deadline, caller, result))
+    {
+        result = pLibc_pthread_cond_timedwait(condition, mutex, deadline);
+    }
+
+    return result;
+}
+
+inline static int pthread_cond_clockwait_shim(pthread_cond_t* condition, pthread_mutex_t* mutex, clockid_t clockId,
+                                              const struct timespec* deadline, const void* caller)
+{
+    int result;
+
+    if (!pthreadConditionWait(condition, mutex, clockId, deadline, caller, result))
+    {
+        result = pLibc_pthread_cond_clockwait(condition, mutex, clockId, deadline);
+    }
+
+    return result;
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+// QTimer method shims.
+
+class QTimerIdAccessor: public QObject
+{
+public:
+    int id;
+};
+
+static constexpr int inactiveTimerID    = -1;
+static constexpr int fakeActiveTimerID  = 0;    // Value considered active by QTimer, but not by QObject::killTimer();
+
+
+inline static void QTimer_start_shim(QTimer* timer)
+{
+    if (timer->isSingleShot() && (timer->interval() == 0))
+    {
+        // In case of zero interval single-shot timer, invoke real Qt5Base QTimer::singleShot() implementation, which performs deferred
+        // invocation of <slotObj> via queued signal-slot connection.
+
+        // NOTE: This overload of QTimer::singleShot(), taking a functor argument, hasn't been shimmed
+        QTimer::singleShot(0, [=](){emit timer->timeout({});});
+
+        return;
+    }
+
+    TimerShard& shard = timerShard(timer);
+
+    qint64 dueTime = currentTime(*shard.domain) + timer->interval() * nsPerMS;
+
+    if (timer->timerType() != Qt::PreciseTimer)
+    {
+        // Only precise timers are scheduled to the nS, others are due on a whole mS
+        dueTime = (dueTime + nsPerMS - 1) / nsPerMS * nsPerMS;
+    }
+
+    bool wasScheduled;
+
+    {
+        QMutexLocker lock(&shard.mutex);
+
+        wasScheduled = shard.schedule->contains(timer);
+
+        shard.schedule->schedule(timer, dueTime);
+        shard.scheduleChanged();
+
+        if (!shard.skippedTicks.empty())
+        {
+            shard.skippedTicks.erase(timer);
+        }
+    }
+
+    reinterpret_cast<QTimerIdAccessor*>(timer)->id = fakeActiveTimerID;
+
+    if (!wasScheduled)
+    {
+        countActiveTimers(1);
+
+        // Have to use event handler connected to QObject::destroyed() signal to remove timer from its shard's schedule on destruction, rather than shimming QTimer::~QTimer()
+        // destructors (_ZN6QTimerD0Ev etc.), as the shim destructors is not invoked in the case of dynamically allocated timers, (they instead invoke their
+        // real virtual destructor via their virtual method table.)
+        //
+        // Restarting an already scheduled timer just reschedules it, so only need to connect handler when timer first enters the schedule.
+        std::weak_ptr<TimerShard> weakShard = shard.shared_from_this();
+
+        QObject::connect(timer, &QObject::destroyed, [weakShard](QObject* obj)    {
+                                                                                    std::shared_ptr<TimerShard> pShard = weakShard.lock();
+
+                                                                                    if (!pShard)
+                                                                                    {
+                                                                                        return;     // Shard since pruned
+                                                                                    }
+
+                                                                                    QMutexLocker lock(&pShard->mutex);
+
+                                                                                    if (pShard->schedule->cancel((QTimer*)obj))
+                                                                                    {
+                                                                                        countActiveTimers(-1);
+                                                                                        pShard->scheduleChanged();
+                                                                                    }
+
+                                                                                    pShard->skippedTicks.erase((QTimer*)obj);
+                                                                                });
+    }
+
+    if (shard.domain->fakedNSSinceEpoch == -1)
+    {
+        // Tracking real time, so idle timer may need bringing forward to generate this timer's timeout on time
+        requestIdleTimerRearm(dueTime);
+    }
+}
+
+inline static void QTimer_start_shim(QTimer* timer, int interval)
+{
+    reinterpret_cast<QTimerIdAccessor*>(timer)->id = inactiveTimerID;
+
+    pQt5Core_QTimer_setInterval(timer, interval);
+
+    timer->start();
+}
+
+inline static void QTimer_stop_shim(QTimer* timer)
+{
+    reinterpret_cast<QTimerIdAccessor*>(timer)->id = inactiveTimerID;
+
+    TimerShard& shard = timerShard(timer);
+
+    QMutexLocker lock(&shard.mutex);
+
+    if (shard.schedule->cancel(timer))
+    {
+        countActiveTimers(-1);
+        shard.scheduleChanged();
+    }
+
+    if (!shard.skippedTicks.empty())
+    {
+        shard.skippedTicks.erase(timer);
+    }
+}
+
+inline static void QTimer_setInterval_shim(QTimer* timer, int interval)
+{
+    bool wasActive = timer->isActive();
+
+    reinterpret_cast<QTimerIdAccessor*>(timer)->id = inactiveTimerID;
+
+    pQt5Core_QTimer_setInterval(timer, interval);
+
+    if (wasActive)
+    {
+        timer->start();
+    }
+}
+
+inline static int QTimer_remainingTime_shim(QTimer* timer)
+{
+    qint64 timeDue;
+    bool isScheduled;
+
+    TimerShard& shard = timerShard(timer);
+
+    {
+        QMutexLocker lock(&shard.mutex);
+
+        isScheduled = shard.schedule->dueTime(timer, timeDue);
+    }
+
+    if (isScheduled)
+    {
+        // Round up, so a timer isn't reported as due until it actually is
+        return static_cast<int>((timeDue - currentTime(*shard.domain) + nsPerMS - 1) / nsPerMS);
+    }
+    else
+    {
+        return -1;
+    }
+}
+
+inline static void QTimer_singleShotImpl_shim(  int msec,
+                                                Qt::TimerType timerType,
+                                                const QObject *receiver,
+                                                QtPrivate::QSlotObjectBase *slotObj)
+{
+    if (msec == 0)
+    {
+        // In case of zero interval single-shot timer, invoke real Qt5Base QTimer::singelShot() implementation, which performs deferred
+        // invocation of <slotObj> via queued signal-slot connection.
+        pQt5Core_QTimer_singleShotImpl(0, timerType, receiver, slotObj);
+        return;
+    }
+
+
+    // NOTE: Function expected to take ownership of <slotObj>, but dispose of it via. destroyIfLastRef() call rather than delete
+
+    QTimer* pTimer = new QTimer();
+
+    pTimer->setInterval(msec);
+    pTimer->setSingleShot(true);
+
+    QObject::connect(pTimer, &QTimer::timeout, [=](void){
+                                                            void *empty_argv[] = { nullptr };
+
+                                                            slotObj->call(const_cast<QObject*>(receiver), empty_argv);
+
+                                                            slotObj->destroyIfLastRef();
+
+                                                            pTimer->stop();
+
+                                                            delete pTimer;
+                                                        });
+
+    pTimer->start();
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+// Declaration of compiler specific shim function wrappers with names matching the C++ name-mangled symbols corresponding
+// to methods exported by libQt5Core.so, overriding libQt5Core originals due to LD_PRELOAD.  Functions are declared with "C"
+// external linkage in order to prevent further mangling.
+//
+// Mangled names discovered by examining "objdump -t .../libQt5Core.so" output
+
+#ifdef __GNUC__
+
+// Overrides of C++ name-mangled identifiers generated by GCC compiling Qt5 (verified for Qt 5.9 & 5.15)
+
+extern "C" QDateTime _ZN9QDateTime15currentDateTimeEv(void)
+{
+    return QDateTime_currentDateTime_shim();
+}
+
+extern "C" QDateTime _ZN9QDateTime18currentDateTimeUtcEv(void)
+{
+    return QDateTime_currentDateTimeUtc_shim();
+}
+
+extern "C" qint64 _ZN9QDateTime22currentMSecsSinceEpochEv(void)
+{
+    return QDateTime_currentMSecsSinceEpoch_shim();
+}
+
+extern "C" qint64 _ZN9QDateTime21currentSecsSinceEpochEv(void)
+{
+    return QDateTime_currentSecsSinceEpoch_shim();
+
+}
+
+extern "C" QTime _ZN5QTime11currentTimeEv(void)
+{
+    return QTime_currentTime_shim();
+}
+
+extern "C" bool _ZNK13QElapsedTimer7isValidEv(QElapsedTimer* timer)
+{
+    return QElapsedTimer_isValid_shim(timer);
+}
+
+extern "C" qint64 _ZNK13QElapsedTimer7elapsedEv(QElapsedTimer* timer)
+{
+    return QElapsedTimer_elapsed_shim(timer);
+}
+
+extern "C" bool _ZNK13QElapsedTimer10hasExpiredEx(QElapsedTimer* timer, qint64 timeout)
+{
+    return _ZNK13QElapsedTimer_hasExpired_shim(timer, timeout);
+}
+
+extern "C" void _ZN13QElapsedTimer10invalidateEv(QElapsedTimer* timer)
+{
+    return QElapsedTimer_invalidate_shim(timer);
+}
+
+extern "C" void _ZN13QElapsedTimer5startEv(QElapsedTimer* timer)
+{
+    return QElapsedTimer_start_shim(timer);
+}
+
+extern "C" qint64 _ZN13QElapsedTimer7restartEv(QElapsedTimer* timer)
+{
+    return QElapsedTimer_restart_shim(timer);
+}
+
+extern "C" qint64 _ZNK13QElapsedTimer6secsToERKS_(QElapsedTimer* timer, const QElapsedTimer& other)
+{
+    return QElapsedTimer_secsTo_shim(timer, other);
+}
+
+extern "C" qint64 _ZNK13QElapsedTimer19msecsSinceReferenceEv(QElapsedTimer* timer)
+{
+    return QElapsedTimer_msecsSinceReference_shim(timer);
+
+}
+
+extern "C" qint64 _ZNK13QElapsedTimer12nsecsElapsedEv(QElapsedTimer* timer)
+{
+    return QElapsedTimer_nsecsElapsed_shim(timer);
+}
+
+extern "C" qint64 _ZNK13QElapsedTimer7msecsToERKS_(QElapsedTimer* timer, const QElapsedTimer& other)
+{
+    return QElapsedTimer_msecsTo_shim(timer, other);
+}
+
+extern "C" QDeadlineTimer _ZN14QDeadlineTimer7currentEN2Qt9TimerTypeE(Qt::TimerType timerType)
+{
+    return QDeadlineTimer_current_shim(timerType);
+}
+
+extern "C" void _ZN14QDeadlineTimerC1ExN2Qt9TimerTypeE(QDeadlineTimer* timer, qint64 msecs, Qt::TimerType timerType)
+{
+    reinterpret_cast<QDeadlineTimerAccessor*>(timer)->t2 = 0;
+
+    return QDeadlineTimer_setRemainingTime_shim(timer, msecs, timerType);
+}
+
+extern "C" void _ZN14QDeadlineTimerC2ExN2Qt9TimerTypeE(QDeadlineTimer* timer, qint64 msecs, Qt::TimerType timerType)
+{
+    reinterpret_cast<QDeadlineTimerAccessor*>(timer)->t2 = 0;
+
+    return QDeadlineTimer_setRemainingTime_shim(timer, msecs, timerType);
+}
+
+extern "C" void _ZN14QDeadlineTimer16setRemainingTimeExN2Qt9TimerTypeE(QDeadlineTimer* timer, qint64 msecs, Qt::TimerType timerType)
+{
+    return QDeadlineTimer_setRemainingTime_shim(timer, msecs, timerType);
+}
+
+extern "C" void _ZN14QDeadlineTimer23setPreciseRemainingTimeExxN2Qt9TimerTypeE(QDeadlineTimer* timer,
+                                                                               qint64 secs,
+                                                                               qint64 nsecs,
+                                                                               Qt::TimerType timerType)
+{
+    return QDeadlineTimer_setPreciseRemainingTime_shim(timer, secs, nsecs, timerType);
+}
+
+extern "C" bool _ZNK14QDeadlineTimer10hasExpiredEv(const QDeadlineTimer* timer)
+{
+    return QDeadlineTimer_hasExpired_shim(timer);
+}
+
+extern "C" qint64 _ZNK14QDeadlineTimer13remainingTimeEv(const QDeadlineTimer* timer)
+{
+    return QDeadlineTimer_remainingTime_shim(timer);
+}
+
+extern "C" qint64 _ZNK14QDeadlineTimer18remainingTimeNSecsEv(const QDeadlineTimer* timer)
+{
+    return QDeadlineTimer_remainingTimeNSecs_shim(timer);
+}
+
+extern "C" qint64 _ZNK14QDeadlineTimer21rawRemainingTimeNSecsEv(const QDeadlineTimer* timer)
+{
+    return QDeadlineTimer_rawRemainingTimeNSecs_shim(timer);
+}
+
+extern "C" void _ZN7QThread5sleepEm(unsigned long secs)
+{
+    return QThread_sleep_shim(std::chrono::seconds(secs), pQt5Core_QThread_sleep, secs);
+}
+
+extern "C" void _ZN7QThread6msleepEm(unsigned long msecs)
+{
+    return QThread_sleep_shim(std::chrono::milliseconds(msecs), pQt5Core_QThread_msleep, msecs);
+}
+
+extern "C" void _ZN7QThread6usleepEm(unsigned long usecs)
+{
+    return QThread_sleep_shim(std::chrono::microseconds(usecs), pQt5Core_QThread_usleep, usecs);
+}
+
+extern "C" bool _ZN7QThread4waitEm(QThread* thread, unsigned long time)
+{
+    return QThread_wait_shim(thread, time);
+}
+
+extern "C" bool _ZN7QThread4waitE14QDeadlineTimer(QThread* thread, QDeadlineTimer deadline)
+{
+    return QThread_wait_shim(thread, deadline);
+}
+
+extern "C" bool _ZN14QWaitCondition4waitEP6QMutexm(QWaitCondition* condition, QMutex* mutex, unsigned long time)
+{
+    return QWaitCondition_wait_shim(condition, mutex, time);
+}
+
+extern "C" bool _ZN14QWaitCondition4waitEP6QMutex14QDeadlineTimer(QWaitCondition* condition, QMutex* mutex, QDeadlineTimer deadline)
+{
+    return QWaitCondition_wait_shim(condition, mutex, deadline);
+}
+
+extern "C" void _ZN14QWaitCondition7wakeOneEv(QWaitCondition* condition)
+{
+    return QWaitCondition_wake_shim(condition, pQt5Core_QWaitCondition_wakeOne);
+}
+
+extern "C" void _ZN14QWaitCondition7wakeAllEv(QWaitCondition* condition)
+{
+    return QWaitCondition_wake_shim(condition, pQt5Core_QWaitCondition_wakeAll);
+}
+
+extern "C" bool _ZN10QSemaphore10tryAcquireEii(QSemaphore* semaphore, int n, int timeout)
+{
+    return QSemaphore_tryAcquire_shim(semaphore, n, timeout);
+}
+
+extern "C" bool _ZN6QMutex7tryLockEi(QMutex* mutex, int timeout)
+{
+    return QMutex_tryLock_shim(mutex, timeout);
+}
+
+extern "C" bool _ZN11QThreadPool11waitForDoneEi(QThreadPool* pool, int msecs)
+{
+    return QThreadPool_waitForDone_shim(pool, msecs);
+}
+
+extern "C" bool _ZN8QProcess14waitForStartedEi(QProcess* process, int msecs)
+{
+    return QProcess_waitFor_shim(process, msecs, pQt5Core_QProcess_waitForStarted);
+}
+
+extern "C" bool _ZN8QProcess16waitForReadyReadEi(QProcess* process, int msecs)
+{
+    return QProcess_waitFor_shim(process, msecs, pQt5Core_QProcess_waitForReadyRead);
+}
+
+extern "C" bool _ZN8QProcess19waitForBytesWrittenEi(QProcess* process, int msecs)
+{
+    return QProcess_waitForBytesWritten_shim(process, msecs);
+}
+
+extern "C" bool _ZN8QProcess15waitForFinishedEi(QProcess* process, int msecs)
+{
+    return QProcess_waitFor_shim(process, msecs, pQt5Core_QProcess_waitForFinished);
+}
+
+extern "C" bool _ZN15QAbstractSocket16waitForConnectedEi(QIODevice* socket, int msecs)
+{
+    return QSocket_waitFor_shim(socket, msecs, abstractSocketFunctions, SocketWait::Condition::Connected, abstractSocketFunctions.waitForConnected);
+}
+
+extern "C" bool _ZN15QAbstractSocket16waitForReadyReadEi(QIODevice* socket, int msecs)
+{
+    return QSocket_waitFor_shim(socket, msecs, abstractSocketFunctions, SocketWait::Condition::ReadyRead, abstractSocketFunctions.waitForReadyRead);
+}
+
+extern "C" bool _ZN15QAbstractSocket19waitForBytesWrittenEi(QIODevice* socket, int msecs)
+{
+    return QSocket_waitFor_shim(socket, msecs, abstractSocketFunctions, SocketWait::Condition::BytesWritten, abstractSocketFunctions.waitForBytesWritten);
+}
+
+extern "C" bool _ZN15QAbstractSocket19waitForDisconnectedEi(QIODevice* socket, int msecs)
+{
+    return QSocket_waitFor_shim(socket, msecs, abstractSocketFunctions, SocketWait::Condition::Disconnected, abstractSocketFunctions.waitForDisconnected);
+}
+
+extern "C" bool _ZN12QLocalSocket16waitForConnectedEi(QIODevice* socket, int msecs)
+{
+    return QLocalSocket_waitForConnected_shim(socket, msecs);
+}
+
+extern "C" bool _ZN12QLocalSocket16waitForReadyReadEi(QIODevice* socket, int msecs)
+{
+    return QSocket_waitFor_shim(socket, msecs, localSocketFunctions, SocketWait::Condition::ReadyRead, localSocketFunctions.waitForReadyRead);
+}
+
+extern "C" bool _ZN12QLocalSocket19waitForBytesWrittenEi(QIODevice* socket, int msecs)
+{
+    return QSocket_waitFor_shim(socket, msecs, localSocketFunctions, SocketWait::Condition::BytesWritten, localSocketFunctions.waitForBytesWritten);
+}
+
+extern "C" bool _ZN12QLocalSocket19waitForDisconnectedEi(QIODevice* socket, int msecs)
+{
+    return QSocket_waitFor_shim(socket, msecs, localSocketFunctions, SocketWait::Condition::Disconnected, localSocketFunctions.waitForDisconnected);
+}
+
+extern "C" bool _ZN10QTcpServer20waitForNewConnectionEiPb(QObject* server, int msec, bool* timedOut)
+{
+    return QServer_waitForNewConnection_shim(server, msec, timedOut, pQt5Network_QTcpServer_waitForNewConnection);
+}
+
+extern "C" bool _ZN12QLocalServer20waitForNewConnectionEiPb(QObject* server, int msec, bool* timedOut)
+{
+    return QServer_waitForNewConnection_shim(server, msec, timedOut, pQt5Network_QLocalServer_waitForNewConnection);
+}
+
+extern "C" void _ZN6QTimer5startEv(QTimer* timer)
+{
+    return QTimer_start_shim(timer);
+}
+
+extern "C" void _ZN6QTimer5startEi(QTimer* timer, int interval)
+{
+    return QTimer_start_shim(timer, interval);
+}
+
+extern "C" void _ZN6QTimer4stopEv(QTimer* timer)
+{
+    return QTimer_stop_shim(timer);
+}
+
+extern "C" void _ZN6QTimer11setIntervalEi(QTimer* timer, int interval)
+{
+    return QTimer_setInterval_shim(timer, interval);
+}
+
+extern "C" int _ZNK6QTimer13remainingTimeEv(QTimer* timer)
+{
+    return QTimer_remainingTime_shim(timer);
+}
+
+extern "C" void _ZN6QTimer14singleShotImplEiN2Qt9TimerTypeEPK7QObjectPN9QtPrivate15QSlotObjectBaseE(int msec,
+                                                                                                    Qt::TimerType timerType,
+                                                                                                    const QObject *receiver,
+                                                                                                    QtPrivate::QSlotObjectBase *slotObj)
+{
+    return QTimer_singleShotImpl_shim(msec, timerType, receiver, slotObj);
+}
+
+// Overrides of libc clock, sleep & wait functions.  Those glibc declares with differing signatures or (with _FORTIFY_SOURCE) inline
+// wrappers are defined under an alias carrying their assembler name instead.
+
+extern "C" int clock_gettime(clockid_t clockId, struct timespec* ts) noexcept
+{
+    return clock_gettime_shim(clockId, ts, __builtin_return_address(0));
+}
+
+extern "C" int QtFakeTime_gettimeofday(struct timeval* tv, void* tz) __asm__("gettimeofday");
+
+extern "C" int QtFakeTime_gettimeofday(struct timeval* tv, void* tz)
+{
+    return gettimeofday_shim(tv, tz, __builtin_return_address(0));
+}
+
+extern "C" time_t time(time_t* t) noexcept
+{
+    return time_shim(t, __builtin_return_address(0));
+}
+
+extern "C" int nanosleep(const struct timespec* duration, struct timespec* remaining)
+{
+    return nanosleep_shim(duration, remaining, __builtin_return_address(0));
+}
+
+extern "C" int clock_nanosleep(clockid_t clockId, int flags, const struct timespec* request, struct timespec* remaining)
+{
+    return clock_nanosleep_shim(clockId, flags, request, remaining, __builtin_return_address(0));
+}
+
+extern "C" int usleep(useconds_t usecs)
+{
+    return usleep_shim(usecs, __builtin_return_address(0));
+}
+
+extern "C" unsigned int sleep(unsigned int secs)
+{
+    return sleep_shim(secs, __builtin_return_address(0));
+}
+
+extern "C" int QtFakeTime_poll(struct pollfd* fds, nfds_t nfds, int timeout) __asm__("poll");
+
+extern "C" int QtFakeTime_poll(struct pollfd* fds, nfds_t nfds, int timeout)
+{
+    return poll_shim(fds, nfds, timeout, __builtin_return_address(0));
+}
+
+extern "C" int epoll_wait(int epfd, struct epoll_event* events, int maxEvents, int timeout)
+{
+    return epoll_wait_shim(epfd, events, maxEvents, timeout, __builtin_return_address(0));
+}
+
+extern "C" int select(int nfds, fd_set* readFds, fd_set* writeFds, fd_set* exceptFds, struct timeval* timeout)
+{
+    return select_shim(nfds, readFds, writeFds, exceptFds, timeout, __builtin_return_address(0));
+}
+
+extern "C" int pthread_cond_timedwait(pthread_cond_t* condition, pthread_mutex_t* mutex, const struct timespec* deadline)
+{
+    return pthread_cond_timedwait_shim(condition, mutex, deadline, __builtin_return_address(0));
+}
+
+extern "C" int QtFakeTime_pthread_cond_clockwait(pthread_cond_t* condition, pthread_mutex_t* mutex, clockid_t clockId,
+                                                 const struct timespec* deadline) __asm__("pthread_cond_clockwait");
+
+extern "C" int QtFakeTime_pthread_cond_clockwait(pthread_cond_t* condition, pthread_mutex_t* mutex, clockid_t clockId,
+                                                 const struct timespec* deadline)
+{
+    return pthread_cond_clockwait_shim(condition, mutex, clockId, deadline, __builtin_return_address(0));
+}
+
+#else
+    #error "Unsupported compiler"
+#endif
+
+//------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------
+void __attribute__((constructor)) initialize(void)
+{
+    // Called at shared library load time, in every process library is preloaded into, so kept cheap (with real functions only looked
+    // up as shims need them)
+
+    // Check that libQtFakeTime.so has been specified via. LD_PRELOAD environment variable - necessary for shimming of
+    // libQt5Core.so functions to work
+    const char* LD_PRELOAD = getenv("LD_PRELOAD");
+
+    if ((LD_PRELOAD == nullptr) || (strstr(LD_PRELOAD, "libQtFakeTime.so") == nullptr))
+    {
+        qFatal("libQtFakeTime needs to be pre-loaded via LD_PRELOAD env. variable in order to intercept Qt Core library calls");
+    }
+
+    // Locate libQt5Core.so & GLib code, calls from which to the libc clock, sleep & wait functions are always left in real time
+    dl_iterate_phdr(findRealTimeCode, nullptr);
+
+    // Only patch QDateTimes directly if the loaded Qt Core library holds them the way we expect
+    shortDateTimeLayoutVerified = verifyShortDateTimeLayout();
+}
+
+static void sanitiseTimers(TimeDomain& domain);
+static void generateTimeoutEventforOverdueQTimers(TimeDomain& domain);
+static bool nextTimerDue(TimeDomain& domain, qint64 limit, qint64& timeDue);
+static void generateTimeoutEvent(TimerShard& shard, QTimer& timer, qint64 limit);
+static void writeTraceRecord(TraceRecord& record);
+static void generateTimeoutEventsDueAt(TimeDomain& domain, qint64 timeDue, qint64 limit, bool processEvents);
+static qint64 advanceFakedTime(TimeDomain& domain, qint64 endTime, const std::function<bool(void)>& until);
+
+static std::unique_lock<QMutex> lockClockControl(TimeDomain& domain)
+{
+    // Real QMutex::tryLock(), as the shimmed version would time out on faked time
+    while (!pQt5Core_QMutex_tryLock(&domain.clockControlMutex, 1))
+    {
+        // Another thread is part way through set()/reset()/fastForward(), and may well be waiting on this thread to generate timeouts
+        // for its own timers before it can finish
+        QCoreApplication::sendPostedEvents(nullptr, TimeoutBatchEvent::eventType());
+    }
+
+    return std::unique_lock<QMutex>(domain.clockControlMutex, std::adopt_lock);
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+void QtFakeTime::set(const QDateTime& time)
+{
+    set(timeDomain(), time);
+}
+
+void QtFakeTime::set(qint64 msSinceEpoch)
+{
+    set(timeDomain(), msSinceEpoch);
+}
+
+void QtFakeTime::reset(void)
+{
+    reset(timeDomain());
+}
+
+void QtFakeTime::setFrozen(bool frozen)
+{
+    setFrozen(timeDomain(), frozen);
+}
+
+void QtFakeTime::setAutoAdvance(bool enabled)
+{
+    setAutoAdvance(timeDomain(), enabled);
+}
+
+void QtFakeTime::setRate(double rate)
+{
+    setRate(timeDomain(), rate);
+}
+
+RateStats QtFakeTime::rateStats(void)
+{
+    return rateStats(timeDomain());
+}
+
+void QtFakeTime::fastForward(uint64_t mS)
+{
+    fastForward(timeDomain(), mS);
+}
+
+void QtFakeTime::fastForward(std::chrono::nanoseconds duration)
+{
+    fastForward(timeDomain(), duration);
+}
+
+static void jumpFakedTime(TimeDomain& domain, qint64 nsSinceEpoch)
+{
+    // Jump <domain>'s faked time to <nsSinceEpoch>, or back to real time if -1, leaving its monotonic clock running continuously.
+    // Called with domain's clock control lock held.
+    if ((domain.fakedNSSinceEpoch == -1) && (nsSinceEpoch != -1))
+    {
+        domain.fakedMonotonicNS = monotonicTime() + domain.monotonicLeadNS;
+    }
+    else if ((domain.fakedNSSinceEpoch != -1) && (nsSinceEpoch == -1))
+    {
+        domain.monotonicLeadNS  = domain.fakedMonotonicNS - monotonicTime();
+        domain.fakedMonotonicNS = -1;
+    }
+
+    domain.fakedNSSinceEpoch = nsSinceEpoch;
+
+    notifySleepers(domain);
+}
+
+static void stepFakedTime(TimeDomain& domain, qint64 nsSinceEpoch)
+{
+    // Step <domain>'s faked time forward to <nsSinceEpoch>, along with its monotonic clock.  Called with domain's clock control lock held.
+    assert(domain.fakedNSSinceEpoch != -1);
+
+    qint64 step = nsSinceEpoch - domain.fakedNSSinceEpoch;
+
+    if (step <= 0)
+    {
+        // Timing out an overdue timer, leave time where it is
+        return;
+    }
+
+    domain.fakedMonotonicNS  += step;
+    domain.fakedNSSinceEpoch = nsSinceEpoch;
+
+    notifySleepers(domain);
+}
+
+static void setFakedTime(TimeDomain& domain, qint64 msSinceEpoch)
+{
+    auto lock = lockClockControl(domain);
+
+    jumpFakedTime(domain, msSinceEpoch * nsPerMS);
+
+    sanitiseTimers(domain);
+
+    // Idle timer needs to switch to stepping faked time in lockstep with real time
+    requestIdleTimerRearm(std::numeric_limits<qint64>::min());
+}
+
+void QtFakeTime::set(TimeDomain* domain, const QDateTime& time)
+{
+    assert(domain != nullptr);
+    assert(time.isValid());
+
+    setFakedTime(*domain, time.toMSecsSinceEpoch());
+}
+
+void QtFakeTime::set(TimeDomain* domain, qint64 msSinceEpoch)
+{
+    assert(domain != nullptr);
+    assert(msSinceEpoch > 0);
+
+    setFakedTime(*domain, msSinceEpoch);
+}
+
+void QtFakeTime::reset(TimeDomain* domain)
+{
+    assert(domain != nullptr);
+
+    auto lock = lockClockControl(*domain);
+
+    // Back to real date/time
+    jumpFakedTime(*domain, -1);
+
+    domain->rate = 1.0;
+
+    // Pick up any change of local timezone
+    ++localTimeCacheGeneration;
+
+    resetParticipation(*domain);
+
+    sanitiseTimers(*domain);
+
+    // Idle timer needs re-arming for next timer due in real time
+    requestIdleTimerRearm(std::numeric_limits<qint64>::min());
+}
+
+void QtFakeTime::setFrozen(TimeDomain* domain, bool frozen)
+{
+    assert(domain != nullptr);
+
+    auto lock = lockClockControl(*domain);
+
+    domain->frozen = frozen;
+
+    // Lockstep with real time resumes from point of unfreezing, rather than catching up on real time passed while frozen
+    domain->fakedTimeAtLastIdleTimerTick    = -1;
+    domain->realTimeAtLastIdleTimerTick     = -1;
+
+    requestIdleTimerRearm(std::numeric_limits<qint64>::min());
+}
+
+void QtFakeTime::setAutoAdvance(TimeDomain* domain, bool enabled)
+{
+    assert(domain != nullptr);
+
+    domain->autoAdvance = enabled;
+
+    resetParticipation(*domain);
+}
+
+void QtFakeTime::setRate(TimeDomain* domain, double rate)
+{
+    assert(domain != nullptr);
+    assert(rate > 0);
+
+    auto lock = lockClockControl(*domain);
+
+    if ((domain->fakedNSSinceEpoch == -1) && (rate != 1.0))
+    {
+        // Faked time departs from real time from here on
+        jumpFakedTime(*domain, currentTime(*domain));
+    }
+
+    domain->rate                = rate;
+    domain->lockstepRemainder   = 0;
+
+    domain->rateStatsRealNS     = 0;
+    domain->rateStatsFakedNS    = 0;
+    domain->rateStatsBusyNS     = 0;
+    domain->rateStatsLateTicks  = 0;
+
+    requestIdleTimerRearm(std::numeric_limits<qint64>::min());
+}
+
+RateStats QtFakeTime::rateStats(TimeDomain* domain)
+{
+    assert(domain != nullptr);
+
+    auto lock = lockClockControl(*domain);
+
+    RateStats stats;
+
+    stats.requestedRate = domain->rate;
+    stats.achievedRate  = (domain->rateStatsRealNS > 0) ? double(domain->rateStatsFakedNS) / domain->rateStatsRealNS : 0;
+    stats.load          = (domain->rateStatsRealNS > 0) ? double(domain->rateStatsBusyNS) / domain->rateStatsRealNS : 0;
+    stats.lateTicks     = domain->rateStatsLateTicks;
+
+    return stats;
+}
+
+TimeDomain* QtFakeTime::createTimeDomain(void)
+{
+    QWriteLocker lock(&timeDomainsLock);
+
+    timeDomains.emplace_back(new TimeDomain());
+
+    return timeDomains.back().get();
+}
+
+TimeDomain* QtFakeTime::defaultTimeDomain(void)
+{
+    return &defaultDomain;
+}
+
+TimeDomain* QtFakeTime::timeDomain(void)
+{
+    return &callingThreadTimeDomain();
+}
+
+void QtFakeTime::bindTimeDomain(QThread* thread, TimeDomain* domain)
+{
+    assert(thread != nullptr);
+
+    QWriteLocker lock(&timeDomainsLock);
+
+    bool wasBound = timeDomainBindings.find(thread) != timeDomainBindings.end();
+
+    if ((domain == nullptr) || (domain == &defaultDomain))
+    {
+        timeDomainBindings.erase(thread);
+    }
+    else
+    {
+        timeDomainBindings[thread] = domain;
+
+        if (!wasBound)
+        {
+            // Forget binding once thread is gone, rather than have it apply to any later thread that happens to share the same address
+            QObject::connect(thread, &QObject::destroyed, [thread](void)   {
+                                                                                QWriteLocker lock(&timeDomainsLock);
+
+                                                                                timeDomainBindings.erase(thread);
+                                                                                ++timeDomainBindingsGeneration;
+                                                                            });
+        }
+    }
+
+    ++timeDomainBindingsGeneration;
+}
+
+static void migrateTimerSchedule(TimerShard& shard, TimerStore store)
+{
+    std::unique_ptr<TimerSchedule> schedule(newTimerSchedule(store));
+
+    QMutexLocker lock(&shard.mutex);
+
+    // Migrate active timers across in due order, so those due at the same time retain their relative ordering
+    qint64 timeDue;
+    while (QTimer* pTimer = shard.schedule->next(std::numeric_limits<qint64>::max(), &timeDue))
+    {
+        schedule->schedule(pTimer, timeDue);
+        shard.schedule->cancel(pTimer);
+    }
+
+    shard.schedule = std::move(schedule);
+}
+
+void QtFakeTime::setTimerStore(TimerStore store)
+{
+    timerStore = store;
+
+    for (TimeDomain* domain : allTimeDomains())
+    {
+        for (const std::shared_ptr<TimerShard>& shard : allTimerShards(*domain))
+        {
+            migrateTimerSchedule(*shard, store);
+        }
+    }
+}
+
+std::array<uint64_t, QtFakeTime::latenessHistogramBuckets> QtFakeTime::latenessHistogram(void)
+{
+    std::array<uint64_t, latenessHistogramBuckets> histogram;
+
+    for (int bucket = 0; bucket < latenessHistogramBuckets; ++bucket)
+    {
+        histogram[bucket] = latenessBuckets[bucket].load(std::memory_order_relaxed);
+    }
+
+    return histogram;
+}
+
+void QtFakeTime::resetLatenessHistogram(void)
+{
+    for (std::atomic<uint64_t>& bucket : latenessBuckets)
+    {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+}
+
+static void registerThreadStats(ThreadStats& stats)
+{
+    // Retires <stats> on thread exit
+    class Retirement
+    {
+    public:
+        explicit Retirement(ThreadStats& stats)
+            : stats(stats) {}
+
+        ~Retirement()
+        {
+            std::lock_guard<std::mutex> lock(threadStatsMutex);
+
+            for (int counter = 0; counter < statsCounters; ++counter)
+            {
+                retiredStats[counter] += stats.counters[counter].load(std::memory_order_relaxed);
+            }
+
+            ThreadStats** link = &threadStatsList;
+
+            while (*link != &stats)
+            {
+                link = &(*link)->next;
+            }
+
+            *link = stats.next;
+        }
+
+    private:
+        ThreadStats& stats;
+    };
+
+    {
+        std::lock_guard<std::mutex> lock(threadStatsMutex);
+
+        stats.registered    = true;
+        stats.next          = threadStatsList;
+        threadStatsList     = &stats;
+    }
+
+    thread_local Retirement retirement(stats);
+}
+
+static void totalStats(uint64_t (&totals)[statsCounters])
+{
+    // Counts across all threads, past and present.  Called with <threadStatsMutex> held.
+    std::copy(std::begin(retiredStats), std::end(retiredStats), std::begin(totals));
+
+    for (ThreadStats* stats = threadStatsList; stats != nullptr; stats = stats->next)
+    {
+        for (int counter = 0; counter < statsCounters; ++counter)
+        {
+            totals[counter] += stats->counters[counter].load(std::memory_order_relaxed);
+        }
+    }
+}
+
+Stats QtFakeTime::stats(void)
+{
+    uint64_t totals[statsCounters];
+
+    {
+        std::lock_guard<std::mutex> lock(threadStatsMutex);
+
+        totalStats(totals);
+
+        for (int counter = 0; counter < statsCounters; ++counter)
+        {
+            totals[counter] -= statsBaseline[counter];
+        }
+    }
+
+    Stats stats;
+
+    stats.timeouts              = totals[timeoutsCounter];
+    stats.eventPumps            = totals[eventPumpsCounter];
+    stats.activeTimers          = static_cast<uint64_t>(std::max<int64_t>(0, activeTimers.load(std::memory_order_relaxed)));
+    stats.peakActiveTimers      = static_cast<uint64_t>(std::max<int64_t>(0, peakActiveTimers.load(std::memory_order_relaxed)));
+    stats.elapsedTimerStarts    = totals[elapsedTimerStartsCounter];
+    stats.clockReads            = totals[clockReadsCounter];
+    stats.fastForwardedMS       = totals[fastForwardedNSCounter] / nsPerMS;
+    stats.fastForwardRealNS     = totals[fastForwardRealNSCounter];
+
+    return stats;
+}
+
+void QtFakeTime::resetStats(void)
+{
+    // Counters are only ever written by their own threads, so are reset by moving the baseline they're reported relative to
+    std::lock_guard<std::mutex> lock(threadStatsMutex);
+
+    totalStats(statsBaseline);
+
+    peakActiveTimers = activeTimers.load();
+}
+
+void QtFakeTime::startTrace(size_t records)
+{
+    assert(records > 0);
+
+    QWriteLocker lock(&traceLock);
+
+    if (records != traceCapacity)
+    {
+        traceRecords.reset(new TraceRecord[records]);
+        traceCapacity = records;
+    }
+
+    traceNext   = 0;
+    tracing     = true;
+}
+
+void QtFakeTime::stopTrace(void)
+{
+    QWriteLocker lock(&traceLock);
+
+    tracing = false;
+}
+
+static void appendJSONString(std::string& json, const char* text)
+{
+    json += '"';
+
+    for (; *text != '\0'; ++text)
+    {
+        if ((*text == '"') || (*text == '\\'))
+        {
+            json += '\\';
+            json += *text;
+        }
+        else if (static_cast<unsigned char>(*text) < 0x20)
+        {
+            char escaped[8];
+            snprintf(escaped, sizeof(escaped), "\\u%04x", *text);
+            json += escaped;
+        }
+        else
+        {
+            json += *text;
+        }
+    }
+
+    json += '"';
+}
+
+static void appendTraceEvent(std::string& json, const TraceRecord& record, int pid, qint64 timeNS, qint64 durationNS, bool instant)
+{
+    // Complete event ("X") covering <durationNS>, or thread scoped instant event ("i"), at <timeNS> on timeline <pid>.  Chrome trace times
+    // are in uS.
+    char buffer[256];
+
+    json += "{\"name\":";
+    appendJSONString(json, record.name);
+
+    snprintf(buffer,
+             sizeof(buffer),
+             ",\"cat\":\"%s\",\"ph\":\"%s\",\"pid\":%d,\"tid\":%u,\"ts\":%.3f",
+             (record.kind == TraceRecord::Timeout) ? "timeout" : "fastForward",
+             instant ? "i" : "X",
+             pid,
+             record.thread,
+             timeNS / 1000.0);
+    json += buffer;
+
+    if (instant)
+    {
+        json += ",\"s\":\"t\"";
+    }
+    else
+    {
+        snprintf(buffer, sizeof(buffer), ",\"dur\":%.3f", durationNS / 1000.0);
+        json += buffer;
+    }
+
+    snprintf(buffer,
+             sizeof(buffer),
+             ",\"args\":{\"timer\":\"%p\",\"fakedStartMS\":%lld,\"fakedEndMS\":%lld,\"realDurationUS\":%.3f}},\n",
+             record.timer,
+             static_cast<long long>(record.virtualStartNS / nsPerMS),
+             static_cast<long long>(record.virtualEndNS / nsPerMS),
+             (record.realEndNS - record.realStartNS) / 1000.0);
+    json += buffer;
+}
+
+static void appendTraceMetadata(std::string& json, const char* type, int pid, quint32 tid, const std::string& name)
+{
+    char buffer[128];
+
+    snprintf(buffer, sizeof(buffer), "{\"name\":\"%s\",\"ph\":\"M\",\"pid\":%d,\"tid\":%u,\"args\":{\"name\":", type, pid, tid);
+    json += buffer;
+
+    appendJSONString(json, name.c_str());
+
+    json += "}},\n";
+}
+
+bool QtFakeTime::writeChromeTrace(const QString& fileName)
+{
+    // Snapshot records, oldest first, excluding writers for the duration
+    std::vector<TraceRecord> records;
+
+    {
+        QWriteLocker lock(&traceLock);
+
+        quint64 next    = traceNext;
+        quint64 first   = (next > traceCapacity) ? next - traceCapacity : 0;
+
+        records.reserve(next - first);
+
+        for (quint64 index = first; index < next; ++index)
+        {
+            records.push_back(traceRecords[index % traceCapacity]);
+        }
+    }
+
+    std::vector<std::string> threadNames;
+
+    {
+        std::lock_guard<std::mutex> lock(traceThreadNamesMutex);
+        threadNames = traceThreadNames;
+    }
+
+    // Timeline per domain's faked time (pid 1 onwards, default domain first) plus one for real time (pid 0), each starting from the
+    // earliest record seen on it
+    std::vector<TimeDomain*> domains = allTimeDomains();
+    std::vector<qint64> virtualOrigins(domains.size(), std::numeric_limits<qint64>::max());
+    std::vector<int> pids(records.size());
+    qint64 realOrigin = std::numeric_limits<qint64>::max();
+
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        int domainIndex = static_cast<int>(std::find(domains.begin(), domains.end(), records[i].domain) - domains.begin());
+
+        assert(domainIndex < static_cast<int>(domains.size()));
+
+        pids[i]                     = domainIndex + 1;
+        virtualOrigins[domainIndex] = std::min(virtualOrigins[domainIndex], records[i].virtualStartNS);
+        realOrigin                  = std::min(realOrigin, records[i].realStartNS);
+    }
+
+    std::string json = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    std::vector<int> timelines(1, 0);
+
+    appendTraceMetadata(json, "process_name", 0, 0, "Real time");
+
+    for (size_t domainIndex = 0; domainIndex < domains.size(); ++domainIndex)
+    {
+        if (virtualOrigins[domainIndex] != std::numeric_limits<qint64>::max())
+        {
+            int pid = static_cast<int>(domainIndex) + 1;
+
+            appendTraceMetadata(json, "process_name", pid, 0, (domainIndex == 0) ? "Faked time" : "Faked time (domain " + std::to_string(domainIndex) + ")");
+
+            timelines.push_back(pid);
+        }
+    }
+
+    for (int pid : timelines)
+    {
+        for (size_t tid = 0; tid < threadNames.size(); ++tid)
+        {
+            appendTraceMetadata(json, "thread_name", pid, static_cast<quint32>(tid), threadNames[tid]);
+        }
+    }
+
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        const TraceRecord& record = records[i];
+
+        appendTraceEvent(json,
+                         record,
+                         pids[i],
+                         record.virtualStartNS - virtualOrigins[pids[i] - 1],
+                         record.virtualEndNS - record.virtualStartNS,
+                         record.kind == TraceRecord::Timeout);
+
+        appendTraceEvent(json, record, 0, record.realStartNS - realOrigin, record.realEndNS - record.realStartNS, false);
+    }
+
+    // Trailing comma isn't valid JSON
+    json.erase(json.size() - 2);
+    json += "\n]}\n";
+
+    QFile file(fileName);
+
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        return false;
+    }
+
+    return file.write(json.data(), static_cast<qint64>(json.size())) == static_cast<qint64>(json.size());
 }
 
-extern "C" qint64 _ZNK13QElapsedTimer7elapsedEv(QElapsedTimer* timer)
+void QtFakeTime::setBatchedTimeouts(bool enabled)
 {
-    return QElapsedTimer_elapsed_shim(timer);
+    batchedTimeouts = enabled;
 }
 
-extern "C" bool _ZNK13QElapsedTimer10hasExpiredEx(QElapsedTimer* timer, qint64 timeout)
+void QtFakeTime::setFakeLibcClocks(bool realtime, bool monotonic)
 {
-    return _ZNK13QElapsedTimer_hasExpired_shim(timer, timeout);
+    fakedLibcClocks = (realtime ? fakeLibcRealtime : 0) | (monotonic ? fakeLibcMonotonic : 0);
 }
 
-extern "C" void _ZN13QElapsedTimer10invalidateEv(QElapsedTimer* timer)
+void QtFakeTime::setFakeLibcWaits(bool enabled)
 {
-    return QElapsedTimer_invalidate_shim(timer);
+    fakedLibcWaits = enabled;
 }
 
-extern "C" void _ZN13QElapsedTimer5startEv(QElapsedTimer* timer)
+void QtFakeTime::setSkipAhead(QTimer* timer, bool enabled)
 {
-    return QElapsedTimer_start_shim(timer);
+    QWriteLocker lock(&skipAheadLock);
+
+    bool wasConfigured = skipAheadTimers.find(timer) != skipAheadTimers.end();
+
+    skipAheadTimers[timer] = enabled;
+    skipAheadConfigured    = true;
+
+    if (!wasConfigured)
+    {
+        QObject::connect(timer, &QObject::destroyed, [](QObject* obj)   {
+                                                                            QWriteLocker lock(&skipAheadLock);
+
+                                                                            skipAheadTimers.erase((QTimer*)obj);
+                                                                            skipAheadConfigured = !skipAheadTimers.empty() || !skipAheadPatterns.empty();
+                                                                        });
+    }
 }
 
-extern "C" qint64 _ZN13QElapsedTimer7restartEv(QElapsedTimer* timer)
+void QtFakeTime::setSkipAhead(const QString& objectNamePattern)
 {
-    return QElapsedTimer_restart_shim(timer);
+    QWriteLocker lock(&skipAheadLock);
+
+    skipAheadPatterns.push_back(QRegExp(objectNamePattern, Qt::CaseSensitive, QRegExp::Wildcard));
+    skipAheadConfigured = true;
 }
 
-extern "C" qint64 _ZNK13QElapsedTimer6secsToERKS_(QElapsedTimer* timer, const QElapsedTimer& other)
+void QtFakeTime::clearSkipAhead(void)
 {
-    return QElapsedTimer_secsTo_shim(timer, other);
+    {
+        QWriteLocker lock(&skipAheadLock);
+
+        skipAheadPatterns.clear();
+
+        for (auto& ii : skipAheadTimers)
+        {
+            ii.second = false;
+        }
+    }
+
+    for (TimeDomain* domain : allTimeDomains())
+    {
+        for (const std::shared_ptr<TimerShard>& shard : allTimerShards(*domain))
+        {
+            QMutexLocker lock(&shard->mutex);
+
+            shard->skippedTicks.clear();
+        }
+    }
 }
 
-extern "C" qint64 _ZNK13QElapsedTimer19msecsSinceReferenceEv(QElapsedTimer* timer)
+void QtFakeTime::setSkippedTicksHandler(SkippedTicksHandler handler)
 {
-    return QElapsedTimer_msecsSinceReference_shim(timer);
+    QWriteLocker lock(&skipAheadLock);
 
+    skippedTicksHandler = handler;
 }
 
-extern "C" qint64 _ZNK13QElapsedTimer12nsecsElapsedEv(QElapsedTimer* timer)
+void QtFakeTime::fastForward(TimeDomain* domain, uint64_t mS)
 {
-    return QElapsedTimer_nsecsElapsed_shim(timer);
+    fastForward(domain, std::chrono::milliseconds(mS));
 }
 
-extern "C" qint64 _ZNK13QElapsedTimer7msecsToERKS_(QElapsedTimer* timer, const QElapsedTimer& other)
+static qint64 fastForwardStartTime(TimeDomain& domain)
 {
-    return QElapsedTimer_msecsTo_shim(timer, other);
+    // Faked time a fast-forward of <domain> starts from, starting faking from current time if not already.  Called with domain's clock
+    // control lock held.
+    qint64 startTime = domain.fakedNSSinceEpoch;
+
+    if (startTime == -1)
+    {
+        startTime = currentTime(domain);
+
+        jumpFakedTime(domain, startTime);
+
+        requestIdleTimerRearm(std::numeric_limits<qint64>::min());
+    }
+
+    return startTime;
 }
 
-extern "C" void _ZN6QTimer5startEv(QTimer* timer)
+static qint64 fastForwardFakedTime(TimeDomain& domain,
+                                   qint64 startTime,
+                                   qint64 endTime,
+                                   const std::function<bool(void)>& until,
+                                   bool lockstep = false)
 {
-    return QTimer_start_shim(timer);
+    // Fast-forward <domain>'s faked time from <startTime> to <endTime>, or until <until> holds after a batch of timeouts, returning faked
+    // time consumed.  Idle timer steps in <lockstep> with real time are left out of stats, as they're not time fast-forwarded.  Called
+    // with domain's clock control lock held.
+    qint64 realStartNS = monotonicTime();
+
+    ++fastForwardDepth;
+
+    endTime = advanceFakedTime(domain, endTime, until);
+
+    // Process any outstanding events that might have arisen from timeout (in particular any deferred signal-slot connections)
+    QCoreApplication::processEvents();
+
+    --fastForwardDepth;
+
+    qint64 realEndNS    = monotonicTime();
+    qint64 consumed     = qMax<qint64>(0, endTime - startTime);
+
+    if (!lockstep)
+    {
+        count(eventPumpsCounter);
+        countFastForward(consumed, realStartNS);
+    }
+
+    if (tracing)
+    {
+        TraceRecord record;
+
+        record.kind             = TraceRecord::FastForward;
+        record.timer            = nullptr;
+        record.domain           = &domain;
+        record.virtualStartNS   = startTime;
+        record.virtualEndNS     = endTime;
+        record.realStartNS      = realStartNS;
+        record.realEndNS        = realEndNS;
+
+        strcpy(record.name, lockstep ? "lockstep" : "fastForward");
+
+        writeTraceRecord(record);
+    }
+
+    return consumed;
 }
 
-extern "C" void _ZN6QTimer5startEi(QTimer* timer, int interval)
+void QtFakeTime::fastForward(TimeDomain* domain, std::chrono::nanoseconds duration)
 {
-    return QTimer_start_shim(timer, interval);
+    assert(domain != nullptr);
+    assert(duration.count() >= 0);
+
+    auto lock = lockClockControl(*domain);
+
+    qint64 startTime = fastForwardStartTime(*domain);
+
+    fastForwardFakedTime(*domain, startTime, startTime + duration.count(), nullptr);
 }
 
-extern "C" void _ZN6QTimer4stopEv(QTimer* timer)
+bool QtFakeTime::advanceToNextTimer(void)
 {
-    return QTimer_stop_shim(timer);
+    return advanceToNextTimer(timeDomain());
 }
 
-extern "C" void _ZN6QTimer11setIntervalEi(QTimer* timer, int interval)
+bool QtFakeTime::advanceToNextTimer(TimeDomain* domain)
 {
-    return QTimer_setInterval_shim(timer, interval);
+    assert(domain != nullptr);
+
+    auto lock = lockClockControl(*domain);
+
+    qint64 timeDue;
+
+    if (!nextTimerDue(*domain, std::numeric_limits<qint64>::max(), timeDue))
+    {
+        return false;
+    }
+
+    qint64 startTime = fastForwardStartTime(*domain);
+
+    // Timer may already be overdue, if faked time has proceeded in lockstep with real time since idle timer last ticked
+    fastForwardFakedTime(*domain, startTime, qMax(startTime, timeDue), nullptr);
+
+    return true;
 }
 
-extern "C" int _ZNK6QTimer13remainingTimeEv(QTimer* timer)
+uint64_t QtFakeTime::fastForwardUntil(const std::function<bool(void)>& predicate, uint64_t maxMS)
 {
-    return QTimer_remainingTime_shim(timer);
+    return fastForwardUntil(timeDomain(), predicate, maxMS);
 }
 
-extern "C" void _ZN6QTimer14singleShotImplEiN2Qt9TimerTypeEPK7QObjectPN9QtPrivate15QSlotObjectBaseE(int msec,
-                                                                                                    Qt::TimerType timerType,
-                                                                                                    const QObject *receiver,
-                                                                                                    QtPrivate::QSlotObjectBase *slotObj)
+std::chrono::nanoseconds QtFakeTime::fastForwardUntil(const std::function<bool(void)>& predicate, std::chrono::nanoseconds maxDuration)
 {
-    return QTimer_singleShotImpl_shim(msec, timerType, receiver, slotObj);
+    return fastForwardUntil(timeDomain(), predicate, maxDuration);
 }
 
-#else
-    #error "Unsupported compiler"
-#endif
+uint64_t QtFakeTime::fastForwardUntil(TimeDomain* domain, const std::function<bool(void)>& predicate, uint64_t maxMS)
+{
+    std::chrono::nanoseconds consumed = fastForwardUntil(domain, predicate, std::chrono::milliseconds(maxMS));
 
+    return static_cast<uint64_t>(consumed.count() / nsPerMS);
+}
+
+std::chrono::nanoseconds QtFakeTime::fastForwardUntil(TimeDomain* domain,
+                                                      const std::function<bool(void)>& predicate,
+                                                      std::chrono::nanoseconds maxDuration)
+{
+    assert(domain != nullptr);
+    assert(predicate);
+    assert(maxDuration.count() >= 0);
+
+    if (predicate())
+    {
+        return std::chrono::nanoseconds(0);
+    }
+
+    auto lock = lockClockControl(*domain);
+
+    qint64 startTime = fastForwardStartTime(*domain);
+
+    return std::chrono::nanoseconds(fastForwardFakedTime(*domain, startTime, startTime + maxDuration.count(), predicate));
+}
+
+static qint64 advanceFakedTime(TimeDomain& domain, qint64 endTime, const std::function<bool(void)>& until)
+{
+    // Incrementally step faked current time to <endTime>, generating QTimer::timeout() events for any active timers that timeout along
+    // the way, returning time reached.  Stops short at the first batch of timeouts after which <until> (if specified) holds.  Called
+    // with domain's clock control lock held.
+    while (true)
+    {
+        qint64 timeDue;
+
+        if (!nextTimerDue(domain, endTime, timeDue))
+        {
+            // No timers active at all, or earliest timer due point is beyond fast-forward period
+            break;
+        }
+
+        // Perform intermediate increment of <fakedNSSinceEpoch> to <timeDue>
+        stepFakedTime(domain, timeDue);
+
+        // Time out every timer due at <timeDue> (on their owning threads) before moving time on any further
+        generateTimeoutEventsDueAt(domain, timeDue, endTime, true);
+
+        if (until && until())
+        {
+            // Overdue timers leave time where it is
+            return domain.fakedNSSinceEpoch;
+        }
+    }
+
+    // Perform final increment of faked current time
+    stepFakedTime(domain, endTime);
+
+    return endTime;
+}
 //------------------------------------------------------------------------------------------------------------------------
-//------------------------------------------------------------------------------------------------------------------------
-static void* h_libQt5Core = nullptr;
 
-void __attribute__((constructor)) initialize(void)
-{
-    // Called at shared library load time
+static void sanitiseTimers(TimeDomain& domain)
+{
+    // Called on arbitrary jumps in current time due to set/reset calls, which could render state of currently active
+    // timers nonsensical.
+
+    // Reset idle timer state variables so that next idle timer event performs resynchronisation
+    domain.fakedTimeAtLastIdleTimerTick = -1;
+    domain.realTimeAtLastIdleTimerTick  = -1;
+
+    qint64 timeNow          = currentTime(domain);
+
+    // Have any QElapsedTimer whose start time is now in the future restarted at current time on next use
+    {
+        QWriteLocker lock(&domain.timeJumpsLock);
+
+        domain.timeJumps.push_back(timeNow);
+
+        if (domain.timeJumps.size() > timeJumpHistory)
+        {
+            domain.timeJumps.pop_front();
+        }
+
+        ++domain.timeJumpGeneration;
+    }
+
+    for (const std::shared_ptr<TimerShard>& shard : allTimerShards(domain))
+    {
+        // Work from snapshot of scheduled timers, as restarting/cancelling them below modifies shard's schedule (and can't hold
+        // shard's lock while restarting them)
+        std::vector<std::pair<QTimer*, qint64>> timers;
+
+        {
+            QMutexLocker lock(&shard->mutex);
+
+            for (QTimer* pTimer : shard->schedule->timers())
+            {
+                qint64 timerDueTime = 0;
+                shard->schedule->dueTime(pTimer, timerDueTime);
+
+                timers.emplace_back(pTimer, timerDueTime);
+            }
+        }
+
+        for (const std::pair<QTimer*, qint64>& ii : timers)
+        {
+            QTimer& timer           = *ii.first;
+            qint64 timerDueTime     = ii.second;
+            qint64 timerInterval    = timer.interval() * nsPerMS;
+            qint64 timerStartTime   = timerDueTime - timerInterval;
+
+            if ((timeNow < timerStartTime) ||                       // Jump backwards in time to before start point of timer
+                (timeNow > timerDueTime + timerInterval))       // Jump forward in time well beyond due time - *probably* not appropriate to be firing off timer event
+            {
+                if (timer.isSingleShot())
+                {
+                    // Cancel single single-shot timer
+                    QMutexLocker lock(&shard->mutex);
+
+                    if (shard->schedule->cancel(&timer))
+                    {
+                        countActiveTimers(-1);
+                        shard->scheduleChanged();
+                    }
+                }
+                else
+                {
+                    // Restart repeating timer
+                    timer.start();
+                }
+            }
+
+            // Otherwise current state of timer still valid
+        }
+    }
+
+    // Only overdue timers remaining in timer schedules should be those who have expired *recently*
+    generateTimeoutEventforOverdueQTimers(domain);
+}
+
+static bool nextTimerDue(TimeDomain& domain, qint64 limit, qint64& timeDue)
+{
+    // Due time of earliest timer due at or before <limit> across all shards of <domain>, returning false if there is none.  Looks
+    // ahead without reorganising any shard's schedule, as <limit> may well be beyond faked current time.
+    bool found = false;
+
+    QReadLocker registryLock(&domain.timerShardsLock);
+
+    for (const std::shared_ptr<TimerShard>& candidateShard : domain.timerShards)
+    {
+        if (candidateShard->parked || !candidateShard->hasTimers)
+        {
+            continue;
+        }
+
+        QMutexLocker lock(&candidateShard->mutex);
+
+        qint64 candidateTimeDue;
+
+        if (candidateShard->schedule->earliestDueTime(candidateTimeDue) && (candidateTimeDue <= limit))
+        {
+            found   = true;
+            timeDue = candidateTimeDue;
+
+            // Subsequent shards need only be searched for timers due strictly earlier
+            limit   = candidateTimeDue - 1;
+        }
+    }
+
+    return found;
+}
+
+static bool isSkipAheadTimer(const QTimer& timer)
+{
+    QReadLocker lock(&skipAheadLock);
+
+    auto ii = skipAheadTimers.find(&timer);
+
+    if (ii != skipAheadTimers.end())
+    {
+        return ii->second;
+    }
+
+    if (!skipAheadPatterns.empty())
+    {
+        QString objectName = timer.objectName();
+
+        for (const QRegExp& pattern : skipAheadPatterns)
+        {
+            if (pattern.exactMatch(objectName))
+            {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+static void recordLateness(qint64 mS)
+{
+    // Bucket 0 counts timeouts under 1mS late, bucket n those [2^(n-1), 2^n) mS late, with final bucket also counting anything later
+    int bucket = 0;
+
+    while ((mS >= (qint64(1) << bucket)) && (bucket < latenessHistogramBuckets - 1))
+    {
+        ++bucket;
+    }
+
+    latenessBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+static quint32 traceThread(void)
+{
+    // Calling thread's index in <traceThreadNames>, allocated on first record written from thread
+    thread_local quint32 index = std::numeric_limits<quint32>::max();
+
+    if (index == std::numeric_limits<quint32>::max())
+    {
+        std::string name = QThread::currentThread()->objectName().toUtf8().constData();
+
+        if (name.empty() && isApplicationThread())
+        {
+            name = "Main thread";
+        }
+
+        std::lock_guard<std::mutex> lock(traceThreadNamesMutex);
+
+        index = static_cast<quint32>(traceThreadNames.size());
+
+        traceThreadNames.push_back(name.empty() ? "Thread " + std::to_string(index) : name);
+    }
+
+    return index;
+}
+
+static void setTraceName(TraceRecord& record, const QObject& object)
+{
+    // Plain ASCII copy of <object>'s objectName, or its class name if it has none, truncated to fit <record>
+    constexpr int maxLength = sizeof(record.name) - 1;
+
+    QString objectName = object.objectName();
+
+    if (objectName.isEmpty())
+    {
+        strncpy(record.name, object.metaObject()->className(), maxLength);
+        record.name[maxLength] = '\0';
+
+        return;
+    }
+
+    int length = std::min(objectName.size(), maxLength);
+
+    for (int i = 0; i < length; ++i)
+    {
+        ushort c = objectName.at(i).unicode();
+
+        record.name[i] = (c < 0x80) ? static_cast<char>(c) : '?';
+    }
+
+    record.name[length] = '\0';
+}
+
+static void writeTraceRecord(TraceRecord& record)
+{
+    record.thread = traceThread();
+
+    QReadLocker lock(&traceLock);
+
+    if (!tracing)
+    {
+        // Trace stopped since record was started
+        return;
+    }
+
+    traceRecords[traceNext.fetch_add(1, std::memory_order_relaxed) % traceCapacity] = record;
+}
+
+static void traceTimeout(const TimerShard& shard, const QTimer& timer, qint64 timeDue, qint64 realStartNS)
+{
+    TraceRecord record;
+
+    record.kind             = TraceRecord::Timeout;
+    record.timer            = &timer;
+    record.domain           = shard.domain;
+    record.virtualStartNS   = timeDue;
+    record.virtualEndNS     = timeDue;
+    record.realStartNS      = realStartNS;
+    record.realEndNS        = monotonicTime();
+
+    setTraceName(record, timer);
+
+    writeTraceRecord(record);
+}
+
+static void generateTimeoutEvent(TimerShard& shard, QTimer& timer, qint64 limit)
+{
+    // Generate timeout event for <timer>, given that faked time is being stepped through to <limit>
+    //
+    // Shard lock is only held while examining/updating schedule, never while emitting timeout, as connected slots are free to start/stop
+    // timers of their own.
+
+    qint64 timeDue      = 0;
+    uint64_t ticksSkipped = 0;
+
+    {
+        QMutexLocker lock(&shard.mutex);
+
+        if (!shard.schedule->dueTime(&timer, timeDue) || (timeDue > currentTime(*shard.domain)))
+        {
+            // Timer has been stopped or restarted by another thread since being found due
+            return;
+        }
+
+        qint64 interval = timer.interval() * nsPerMS;
 
-    // Check that libQtFakeTime.so has been specified via. LD_PRELOAD environment variable - necessary for shimming of
-    // libQt5Core.so functions to work
-    QString LD_PRELOAD = QProcessEnvironment::systemEnvironment().value("LD_PRELOAD");
+        if (!timer.isSingleShot() && (interval > 0) && (limit - timeDue >= interval))
+        {
+            if (skipAheadConfigured && isSkipAheadTimer(timer))
+            {
+                // Repeating timer will tick multiple times before <limit>.  Rather than generating every tick, analytically skip ahead
+                // to final tick before <limit>, which will be generated once timer is reached again in due order.
+                uint64_t ticksToSkip = static_cast<uint64_t>((limit - timeDue) / interval);
 
-    if (!LD_PRELOAD.contains("libQtFakeTime.so"))
-    {
-        qFatal("libQtFakeTime needs to be pre-loaded via LD_PRELOAD env. variable in order to intercept Qt Core library calls");
-    }
+                shard.schedule->schedule(&timer, timeDue + static_cast<qint64>(ticksToSkip) * interval);
 
-    h_libQt5Core = dlopen("libQt5Core.so", RTLD_LAZY);
+                shard.skippedTicks[&timer] += ticksToSkip;
 
-    // Query libQt5Core library for pointers to original versions of functions that we are shimming
+                return;
+            }
+        }
 
-#ifdef __GNUC__
+        auto ii = shard.skippedTicks.find(&timer);
 
-    // QDateTime methods
+        if (ii != shard.skippedTicks.end())
+        {
+            ticksSkipped = ii->second;
 
-    *(void **) (&pQt5Core_QDateTime_currentDateTime) = dlsym(h_libQt5Core, "_ZN9QDateTime15currentDateTimeEv");
+            shard.skippedTicks.erase(ii);
+        }
+    }
 
-    if (pQt5Core_QDateTime_currentDateTime == nullptr)
+    if (ticksSkipped > 0)
     {
-        qFatal("Couldn't locate symbol associated with QDateTime::currentDateTime() method in libQt5Core.so");
-    }
+        SkippedTicksHandler handler;
 
-    *(void **) (&pQt5Core_QDateTime_currentDateTimeUtc) = dlsym(h_libQt5Core, "_ZN9QDateTime18currentDateTimeUtcEv");
+        {
+            QReadLocker lock(&skipAheadLock);
+            handler = skippedTicksHandler;
+        }
 
-    if (pQt5Core_QDateTime_currentDateTimeUtc == nullptr)
-    {
-        qFatal("Couldn't locate symbol associated with QDateTime::currentDateTimeUtc() method in libQt5Core.so");
+        if (handler)
+        {
+            handler(&timer, ticksSkipped);
+        }
     }
 
-    *(void **) (&pQt5Core_QDateTime_currentMSecsSinceEpoch) = dlsym(h_libQt5Core, "_ZN9QDateTime22currentMSecsSinceEpochEv");
-
-    if (pQt5Core_QDateTime_currentMSecsSinceEpoch == nullptr)
+    if (shard.domain->fakedNSSinceEpoch == -1)
     {
-        qFatal("Couldn't locate symbol associated with QDateTime::currentMSecsSinceEpoch() method in libQt5Core.so");
+        recordLateness((realTime() - timeDue) / nsPerMS);
     }
 
-    *(void **) (&pQt5Core_QDateTime_currentSecsSinceEpoch) = dlsym(h_libQt5Core, "_ZN9QDateTime21currentSecsSinceEpochEv");
+    qint64 traceStartNS = tracing ? monotonicTime() : 0;
 
-    if (pQt5Core_QDateTime_currentSecsSinceEpoch == nullptr)
+    // QTimer::timeout() is declared as "private signal, but can hack around intended access restriction by invoking
+    // with empty braced-init-list.
+    emit timer.timeout({});
+
+    count(timeoutsCounter);
+
+    if (traceStartNS != 0)
     {
-        qFatal("Couldn't locate symbol associated with QDateTime::currentSecsSinceEpoch() method in libQt5Core.so");
+        traceTimeout(shard, timer, timeDue, traceStartNS);
     }
 
-    // QTimer methods
+    // Possible that timer has been explicitly stopped from within slot associated with timeout() signal
+    QMutexLocker lock(&shard.mutex);
 
-    *(void **) (&pQt5Core_QTimer_setInterval) = dlsym(h_libQt5Core, "_ZN6QTimer11setIntervalEi");
+    qint64 timeDueAfterTimeout;
 
-    if (pQt5Core_QTimer_setInterval == nullptr)
+    if (shard.schedule->dueTime(&timer, timeDueAfterTimeout) && (timeDueAfterTimeout == timeDue))
     {
-        qFatal("Couldn't locate symbol associated with QTimer::setInterval() method in libQt5Core.so");
-    }
+        // Doesn't appear that timer has been explicitly stopped or rescheduled from timeout event handling
 
-    *(void **) (&pQt5Core_QTimer_start) = dlsym(h_libQt5Core, "_ZN6QTimer5startEv");
+        if (timer.isSingleShot())
+        {
+            shard.schedule->cancel(&timer);
+            shard.scheduleChanged();
+            reinterpret_cast<QTimerIdAccessor&>(timer).id = inactiveTimerID;
 
-    if (pQt5Core_QTimer_start == nullptr)
-    {
-        qFatal("Couldn't locate symbol associated with QTimer::setInterval() method in libQt5Core.so");
+            countActiveTimers(-1);
+        }
+        else
+        {
+            shard.schedule->schedule(&timer, timeDue + timer.interval() * nsPerMS);
+        }
     }
+}
 
-    *(void **) (&pQt5Core_QTimer_singleShotImpl) = dlsym(h_libQt5Core, "_ZN6QTimer14singleShotImplEiN2Qt9TimerTypeEPK7QObjectPN9QtPrivate15QSlotObjectBaseE");
-
-    if (pQt5Core_QTimer_singleShotImpl == nullptr)
+static void generateShardTimeoutEventsDueAt(TimerShard& shard, qint64 timeDue, qint64 limit, bool processEvents)
+{
+    // Fire every timer in <shard> due at <timeDue>, in the order they were scheduled.  Each timer is either rescheduled to a later time or
+    // removed from the schedule as it fires, so schedule will eventually yield no more timers due at <timeDue>.
+    while (true)
     {
-        qFatal("Couldn't locate symbol associated with QTimer::singleShotImpl() method in libQt5Core.so");
+        QTimer* pTimer;
+
+        {
+            QMutexLocker lock(&shard.mutex);
+            pTimer = shard.schedule->next(timeDue);
+        }
+
+        if (pTimer == nullptr)
+        {
+            break;
+        }
+
+        generateTimeoutEvent(shard, *pTimer, limit);
+
+        if (processEvents && !batchedTimeouts)
+        {
+            // Process any outstanding events that might have arisen from timeout (in particular any deferred signal-slot connections)
+            QCoreApplication::processEvents();
+            count(eventPumpsCounter);
+        }
     }
-#else
-    #error "Unsupported compiler"
-#endif
 
-    if (h_libQt5Core != nullptr)
+    if (processEvents && batchedTimeouts)
     {
-        dlclose(h_libQt5Core);
+        // Process any outstanding events that might have arisen from batch of timeouts
+        QCoreApplication::processEvents();
+        count(eventPumpsCounter);
     }
 }
 
-static void sanitiseTimers(void);
-static void generateTimeoutEventforOverdueQTimers(void);
-static QTimer* nextTimerDue(void);
-static void generateTimeoutEvent(QTimer& timer);
-
-//------------------------------------------------------------------------------------------------------------------------
-void QtFakeTime::set(const QDateTime& time)
+static TimerDispatcher* timerDispatcher(TimerShard& shard)
 {
-    assert(time.isValid());
+    // Dispatcher via. which timeouts are passed to thread owning <shard>'s timers, or nullptr if they should just be generated from
+    // calling thread (as they are for the calling thread's own timers, and those of threads without an event loop to pass them to).
+    //
+    // Caller expected to hold shard's lock.
+    if ((shard.thread == QThread::currentThread()) ||
+        shard.unresponsive ||
+        shard.finished ||
+        (QAbstractEventDispatcher::instance(shard.thread) == nullptr))
+    {
+        return nullptr;
+    }
 
-    fakedMSSinceEpoch               = time.toMSecsSinceEpoch();
+    if (!shard.dispatcher)
+    {
+        shard.dispatcher.reset(new TimerDispatcher(shard));
+        shard.dispatcher->moveToThread(shard.thread);
+    }
 
-    sanitiseTimers();
+    return shard.dispatcher.get();
 }
 
-void set(qint64 msSinceEpoch)
+bool TimeoutBatch::claim(void)
 {
-    assert(msSinceEpoch > 0);
+    if (claimed.exchange(true))
+    {
+        return false;
+    }
 
-    fakedMSSinceEpoch               = msSinceEpoch;
+    --shard->pendingBatches;
 
-    sanitiseTimers();
+    return true;
 }
 
-void QtFakeTime::reset(void)
+void TickBarrier::arrive(void)
 {
-    // Back to real date/time
-    fakedMSSinceEpoch               = -1;
+    QMutexLocker lock(&mutex);
 
-    sanitiseTimers();
+    if (--outstanding == 0)
+    {
+        allArrived.wakeAll();
+    }
 }
 
-void QtFakeTime::fastForward(uint64_t mS)
+static void waitForTimeoutBatches(const std::vector<std::shared_ptr<TimeoutBatch>>& batches, TickBarrier& barrier)
 {
-    if (fakedMSSinceEpoch == -1)
-    {
-        fakedMSSinceEpoch = QDateTime::currentMSecsSinceEpoch();
-    }
+    qint64 waitStartNS = monotonicTime();
 
-    // Incrementally step faked current time to point <mS> in the future, generating QTimer::timeout() events for any active timers that timeout along the way
-    qint64 endTime = fakedMSSinceEpoch + mS;
+    QMutexLocker lock(&barrier.mutex);
 
-    while (true)
+    while (barrier.outstanding > 0)
     {
-        QTimer* pTimer = nextTimerDue();
-
-        if (pTimer == nullptr)
+        // Real wait, as the shimmed one would itself wait on faked time
+        if (pQt5Core_QWaitCondition_wait(&barrier.allArrived, &barrier.mutex, 1))
         {
-            // No timers active at all
-            break;
+            continue;
         }
 
-        qint64 timeDue = qTimerDueTimes.at(pTimer);
+        lock.unlock();
 
-        if (timeDue > endTime)
+        qint64 nowNS = monotonicTime();
+        bool stalled = false;
+
+        for (const std::shared_ptr<TimeoutBatch>& batch : batches)
         {
-            // Earliest timer due point is beyond fast-forward period
-            break;
-        }
+            qint64 startedNS = batch->startedNS;
 
-        // Perform intermediate increment of <fakedMSSinceEpoch> to <timeDue>
-        fakedMSSinceEpoch = timeDue;
+            if ((startedNS == 0) && (nowNS - waitStartNS >= batchPickupTimeoutNS) && batch->claim())
+            {
+                // Owning thread isn't running its event loop (or is busy/blocked elsewhere), so generate its timeouts here, as is done
+                // for threads without an event loop
+                batch->shard->unresponsive = true;
+                generateShardTimeoutEventsDueAt(*batch->shard, batch->timeDue, batch->limit, batch->processEvents);
+                barrier.arrive();
+            }
+            else if ((startedNS != 0) && !batch->finished && (nowNS - startedNS >= batchStallTimeoutNS))
+            {
+                stalled = true;
+            }
+        }
 
-        generateTimeoutEvent(*pTimer);
+        if (stalled)
+        {
+            // A thread is stuck part way through its batch, as it would be on a blocking queued call into this thread from a slot
+            // connected to one of its timeouts, which would otherwise never complete.  Qt offers no means to pick blocking calls out of
+            // the posted event queue, so queued calls are only serviced in this case, and otherwise stay queued until the tick is over.
+            QCoreApplication::sendPostedEvents(nullptr, QEvent::MetaCall);
+        }
 
-        // Process any outstanding events that might have arisen from timeout (in particular any deferred signal-slot connections)
-        QCoreApplication::processEvents();
+        lock.relock();
     }
-
-    // Perform final increment of faked current time
-    fakedMSSinceEpoch = endTime;
-
-    // Process any outstanding events that might have arisen from timeout (in particular any deferred signal-slot connections)
-    QCoreApplication::processEvents();
 }
-//------------------------------------------------------------------------------------------------------------------------
 
-static void sanitiseTimers(void)
+static void generateTimeoutEventsDueAt(TimeDomain& domain, qint64 timeDue, qint64 limit, bool processEvents)
 {
-    // Called on arbitrary jumps in current time due to set/reset calls, which could render state of currently active
-    // timers nonsensical.
-
-    // Reset idle timer state variables so that next idle timer event performs resynchronisation
-    fakedTimeAtLastIdleTimerTick    = -1;
-    realTimeAtLastIdleTimerTick     = -1;
-
-    // Reset any QElapsedTimer whose start date is now in the future.
-    //
-    // CAREFUL HERE: QElapsedTimer pointers in <qElapsedTimerStartTimes> could be stale/invalid and must not be referenced....
-    auto ii = qElapsedTimerStartTimes.begin();
-    while (ii != qElapsedTimerStartTimes.end())
+    // Generate timeouts for every timer due at <timeDue>.  Timers owned by other threads time out on those threads, each thread's batch
+    // of timers in parallel with those of other threads, while the calling thread's own timers time out directly.  Only returns once all
+    // threads are done (or their batches have been reclaimed), so that faked time can't move on while any thread is still dealing with
+    // <timeDue>.
+    std::vector<std::shared_ptr<TimerShard>> localShards;
+    std::vector<std::pair<std::shared_ptr<TimerShard>, TimerDispatcher*>> dispatchers;
+
+    for (const std::shared_ptr<TimerShard>& shard : allTimerShards(domain))
     {
-        if (ii->second > QDateTime::currentMSecsSinceEpoch())
+        if (shard->parked || !shard->hasTimers)
         {
-            // Jump backwards in time to before start point of timer, reset timer start time to current time to avoid possibility
-            // of returning nonsensical negative elapsed time
-            ii->second = QDateTime::currentMSecsSinceEpoch();
+            continue;
         }
-        ++ii;
-    }
 
-    qint64 currentTime      = QDateTime::currentMSecsSinceEpoch();
+        QMutexLocker lock(&shard->mutex);
 
-    auto jj = qTimerDueTimes.begin();
-    while (jj != qTimerDueTimes.end())
-    {
-        QTimer& timer           = *(jj->first);
-        qint64 timerDueTime     = jj->second;
-        qint64 timerInterval    = timer.interval();
-        qint64 timerStartTime   = timerDueTime - timerInterval;
+        if (shard->schedule->next(timeDue) == nullptr)
+        {
+            continue;
+        }
 
-        if (currentTime < timerStartTime)
+        if (TimerDispatcher* dispatcher = timerDispatcher(*shard))
         {
-            // Jump backwards in time to before start point of timer
-            if (timer.isSingleShot())
-            {
-                // Cancel single single-shot timer
-                jj = qTimerDueTimes.erase(jj);
-            }
-            else
-            {
-                // Restart repeating timer
-                timer.start();
-                ++jj;
-            }
+            dispatchers.emplace_back(shard, dispatcher);
         }
         else
         {
-            // Jump forward in time
-            if (currentTime > timerDueTime + timerInterval)
-            {
-                // Jumped well beyond due time - *probably* not appropriate to be firing off timer event
-                if (timer.isSingleShot())
-                {
-                    // Cancel single single-shot timer
-                    jj = qTimerDueTimes.erase(jj);
-                }
-                else
-                {
-                    // Restart repeating timer
-                    timer.start();
-                    ++jj;
-                }
-            }
-            else
-            {
-                // Current state of timer still valid
-                ++jj;
-            }
+            localShards.push_back(shard);
         }
     }
 
-    // Only overdue timers remaining in <qTimerDueTimes> should be those who have expired *recently*
-    generateTimeoutEventforOverdueQTimers();
-}
+    std::shared_ptr<TickBarrier> barrier = std::make_shared<TickBarrier>();
+    std::vector<std::shared_ptr<TimeoutBatch>> batches;
 
-static QTimer* nextTimerDue(void)
-{
-    auto ii = std::min_element( qTimerDueTimes.begin(),
-                                qTimerDueTimes.end(),
-                                [](const std::pair<QTimer*, qint64>& a, const std::pair<QTimer*, qint64>& b)
-                                {
-                                    return a.second < b.second;
-                                });
+    barrier->outstanding = static_cast<int>(dispatchers.size());
 
-    if (ii != qTimerDueTimes.end())
+    for (const std::pair<std::shared_ptr<TimerShard>, TimerDispatcher*>& ii : dispatchers)
     {
-        return ii->first;
+        std::shared_ptr<TimeoutBatch> batch = std::make_shared<TimeoutBatch>();
+
+        batch->shard            = ii.first;
+        batch->timeDue          = timeDue;
+        batch->limit            = limit;
+        batch->processEvents    = processEvents;
+        batch->barrier          = barrier;
+
+        ++ii.first->pendingBatches;
+        batches.push_back(batch);
+
+        QCoreApplication::postEvent(ii.second, new TimeoutBatchEvent(batch));
     }
-    else
+
+    for (const std::shared_ptr<TimerShard>& shard : localShards)
     {
-        return nullptr;
+        generateShardTimeoutEventsDueAt(*shard, timeDue, limit, processEvents);
     }
+
+    waitForTimeoutBatches(batches, *barrier);
 }
 
-static void generateTimeoutEvent(QTimer& timer)
+bool TimerDispatcher::event(QEvent* event)
 {
+    if (event->type() == TimeoutBatchEvent::eventType())
+    {
+        TimeoutBatch& batch = *static_cast<TimeoutBatchEvent*>(event)->batch;
 
-    qint64 timeDue = qTimerDueTimes.at(&timer);
+        shard.unresponsive = false;
 
-    // QTimer::timeout() is declared as "private signal, but can hack around intended access restriction by invoking
-    // with empty braced-init-list.
-    emit timer.timeout({});
+        if (batch.claim())
+        {
+            batch.startedNS = monotonicTime();
+            generateShardTimeoutEventsDueAt(shard, batch.timeDue, batch.limit, batch.processEvents);
+            batch.finished = true;
+            batch.barrier->arrive();
+        }
 
-    // Possible that timer has been explicitly stopped from within slot associated with timeout() signal
-    auto ii = qTimerDueTimes.find(&timer);
+        return true;
+    }
 
-    if ((ii != qTimerDueTimes.end()) && (ii->second == timeDue))
+    return QObject::event(event);
+}
+
+static void generateTimeoutEventforOverdueQTimers(TimeDomain& domain)
+{
+    while (true)
     {
-        // Doesn't appear that timer has been explicitly stopped or rescheduled from timeout event handling
+        qint64 timeNow = currentTime(domain);
 
-        if (timer.isSingleShot())
+        qint64 timeDue;
+
+        if (!nextTimerDue(domain, timeNow, timeDue))
         {
-            qTimerDueTimes.erase(ii);
-            reinterpret_cast<QTimerIdAccessor&>(timer).id = inactiveTimerID;
+            // No timers active at all, or earliest timer due point is in future
+            break;
         }
-        else
+
+        generateTimeoutEventsDueAt(domain, timeDue, timeNow, false);
+    }
+}
+
+static void qApplicationTeardown(void);
+
+static void idleTimerTick(TimeDomain& domain)
+{
+    if (domain.frozen && (domain.fakedNSSinceEpoch != -1))
+    {
+        // Frozen faked time only moves on explicit set()/fastForward() calls
+        return;
+    }
+
+    // Leave time alone while another thread is part way through set()/reset()/fastForward(), trying again next tick
+    if (!pQt5Core_QMutex_tryLock(&domain.clockControlMutex, 0))
+    {
+        return;
+    }
+
+    std::unique_lock<QMutex> lock(domain.clockControlMutex, std::adopt_lock);
+
+    qint64 nsSinceEpoch = domain.fakedNSSinceEpoch;
+
+    if (nsSinceEpoch != -1)
+    {
+        qint64 realTimeNow = realTime();
+
+        if (domain.fakedTimeAtLastIdleTimerTick == nsSinceEpoch)
         {
-            ii->second += timer.interval();
+            // Currently faking time, but 10mS (or more) of real time has passed without any increment to <fakedNSSinceEpoch>,
+            // suggesting test code may well be in waitWhileProcessingEvents() type loop...
+
+            // Step faked time forward in sync. with real time passing, scaled by rate
+            assert(domain.realTimeAtLastIdleTimerTick != -1);
+            assert(domain.realTimeAtLastIdleTimerTick <= realTimeNow);
+
+            qint64 realTimeElapsedSinceLastTick = realTimeNow - domain.realTimeAtLastIdleTimerTick;
+
+            double  fakedTimeElapsed    = realTimeElapsedSinceLastTick * domain.rate + domain.lockstepRemainder;
+            qint64  fakedNSElapsed      = static_cast<qint64>(fakedTimeElapsed);
+
+            domain.lockstepRemainder = fakedTimeElapsed - fakedNSElapsed;
+
+            qint64 busyStart = monotonicTime();
+
+            fastForwardFakedTime(domain, nsSinceEpoch, nsSinceEpoch + fakedNSElapsed, nullptr, true);
+
+            // Host is struggling to keep up with rate if stepping time takes a large part of each tick, or ticks arrive late
+            domain.rateStatsRealNS  += realTimeElapsedSinceLastTick;
+            domain.rateStatsFakedNS += fakedNSElapsed;
+            domain.rateStatsBusyNS  += monotonicTime() - busyStart;
+
+            if (realTimeElapsedSinceLastTick > 2 * lockstepInterval(domain) * nsPerMS)
+            {
+                ++domain.rateStatsLateTicks;
+            }
         }
+
+        domain.fakedTimeAtLastIdleTimerTick = domain.fakedNSSinceEpoch.load();
+        domain.realTimeAtLastIdleTimerTick  = realTimeNow;
+    }
+    else
+    {
+        assert(domain.fakedTimeAtLastIdleTimerTick == -1);
+        assert(domain.realTimeAtLastIdleTimerTick == -1);
+
+        // Generate timeout events for any timers that have become due in real time elapsed since last idle timer event
+        generateTimeoutEventforOverdueQTimers(domain);
     }
 }
 
-static void generateTimeoutEventforOverdueQTimers(void)
+static void armIdleTimer(void)
 {
-    while (true)
+    // (Re)arm idle timer, from the thread it lives in.  While any (unfrozen) domain is faking time the idle timer ticks every 10mS (or
+    // more often for domains running faster than real time) to keep faked time in lockstep with real time.  Otherwise it is armed for
+    // the exact (real) time the earliest timer is due, or left stopped altogether if there are no active timers.
+    assert(idleTimer != nullptr);
+
+    // Until re-armed, have any timer started concurrently by another thread request a further re-arm, in case it is missed below
+    idleTimerRearmPending = false;
+    idleTimerDueTime      = std::numeric_limits<qint64>::max();
+
+    int     interval    = 0;
+    qint64  nextTimeDue = std::numeric_limits<qint64>::max();
+
+    for (TimeDomain* domain : allTimeDomains())
     {
-        QTimer* pTimer = nextTimerDue();
+        if (domain->fakedNSSinceEpoch != -1)
+        {
+            if (!domain->frozen)
+            {
+                int domainInterval = lockstepInterval(*domain);
 
-        if (pTimer == nullptr)
+                interval = (interval == 0) ? domainInterval : qMin(interval, domainInterval);
+            }
+
+            // Frozen domain's timers only time out on fastForward()
+            continue;
+        }
+
+        qint64 timeDue;
+
+        if (nextTimerDue(*domain, std::numeric_limits<qint64>::max(), timeDue) && (timeDue < nextTimeDue))
         {
-            // No timers active at all
-            break;
+            nextTimeDue = timeDue;
         }
+    }
 
-        qint64 timeDue = qTimerDueTimes.at(pTimer);
+    qint64 realTimeNow = realTime();
 
-        if (timeDue > QDateTime::currentMSecsSinceEpoch())
+    // Whole mS until next real time timer is due, rounded up so idle timer doesn't fire before it
+    qint64 msUntilDue = (nextTimeDue != std::numeric_limits<qint64>::max()) ? (nextTimeDue - realTimeNow + nsPerMS - 1) / nsPerMS : 0;
+
+    if (interval != 0)
+    {
+        // Faked time proceeding in lockstep with real time, ticking at least as often as the next real time timer is due
+        if (nextTimeDue != std::numeric_limits<qint64>::max())
         {
-            // Earliest timer due point is in future
-            break;
+            interval = static_cast<int>(qBound<qint64>(0, msUntilDue, interval));
         }
 
-        generateTimeoutEvent(*pTimer);
+        idleTimer->setTimerType((interval < idleTimerLockstepInterval) ? Qt::PreciseTimer : Qt::CoarseTimer);
+    }
+    else if (nextTimeDue != std::numeric_limits<qint64>::max())
+    {
+        interval = static_cast<int>(qBound<qint64>(0, msUntilDue, std::numeric_limits<int>::max()));
+        idleTimer->setTimerType(Qt::PreciseTimer);
+    }
+    else
+    {
+        // Nothing to do until a timer is started
+        pQt5Core_QTimer_stop(idleTimer);
+        return;
+    }
+
+    idleTimerDueTime = realTimeNow + interval * nsPerMS;
+
+    pQt5Core_QTimer_setInterval(idleTimer, interval);
+    pQt5Core_QTimer_start(idleTimer);
+}
+
+bool IdleTimerRearmer::event(QEvent* event)
+{
+    if (event->type() == eventType())
+    {
+        armIdleTimer();
+        return true;
     }
+
+    return QObject::event(event);
 }
 
-static void qApplicationTeardown(void);
+static void requestIdleTimerRearm(qint64 dueTime)
+{
+    // Have idle timer re-armed unless already due to fire by (real) time <dueTime>, as a timer has just been started or a domain has
+    // started/stopped faking time.  Re-arming is deferred to the idle timer's own thread when called from any other thread.
+    if (dueTime >= idleTimerDueTime)
+    {
+        return;
+    }
+
+    QObject* rearmer = idleTimerRearmer;
+
+    if ((rearmer == nullptr) || (QCoreApplication::instance() == nullptr))
+    {
+        // Idle timer not running yet, will be armed once it is
+        return;
+    }
+
+    if (rearmer->thread() == QThread::currentThread())
+    {
+        armIdleTimer();
+    }
+    else if (!idleTimerRearmPending.exchange(true))
+    {
+        QCoreApplication::postEvent(rearmer, new QEvent(IdleTimerRearmer::eventType()));
+    }
+}
 
 static void setupIdleTimer(void)
 {
     // Called on creation of QApplication object, which in gtest style unit test build, may occur multiple times as QApplication object
     // may be set up & torn down for every case(hence the <idleTimerConfigured> guard)
 
-    // Setup a REAL timer (that does not have it's start/stop/etc intercepted) to perform 10mS interval checking for real timeouts of all
-    // the faked timers detailed in <qTimerDueTimes>, such that faked timers will still behave correctly if client test code uses
-    // real-world "wait while processing events" type wait instead of or combined with calls to fastForward()
+    // Setup a REAL timer (that does not have it's start/stop/etc intercepted) to generate real timeouts of all the faked timers
+    // detailed in timer schedules, such that faked timers will still behave correctly if client test code uses real-world "wait while
+    // processing events" type wait instead of or combined with calls to fastForward()
 
-    static QTimer idleTimer;  //This is a functioning REAL timer that does not have it's start/stop/etc intercepted by the library
+    static QTimer idleTimerInstance;  //This is a functioning REAL timer that does not have it's start/stop/etc intercepted by the library
+    static IdleTimerRearmer idleTimerRearmerInstance;
     static bool idleTimerConfigured = false;
 
     if (!idleTimerConfigured)
     {
-        assert(pQt5Core_QTimer_setInterval != nullptr);
-        assert(pQt5Core_QTimer_start != nullptr);
-
-        pQt5Core_QTimer_setInterval(&idleTimer, 10);
+        idleTimer = &idleTimerInstance;
 
-        idleTimer.setTimerType(Qt::CoarseTimer);
-        idleTimer.setSingleShot(true);  // Single shot timer rescheduled from timeout() event, so we don't get multiple events stacking up
+        idleTimer->setSingleShot(true); // Single shot timer rescheduled from timeout() event, so we don't get multiple events stacking up
                                         // in hosts message queue
-        QObject::connect(&idleTimer,
+        QObject::connect(idleTimer,
                          &QTimer::timeout,
                          [&](){
 
-                                if (fakedMSSinceEpoch != -1)
+                                for (TimeDomain* domain : allTimeDomains())
                                 {
-                                    qint64 realTimeNow = pQt5Core_QDateTime_currentMSecsSinceEpoch();
-
-                                    if (fakedTimeAtLastIdleTimerTick == fakedMSSinceEpoch)
-                                    {
-                                        // Currently faking time, but 10mS (or more) of real time has passed without any increment to <fakedMSSinceEpoch>,
-                                        // suggesting test code may well be in waitWhileProcessingEvents() type loop...
-
-                                        // Step faked time forward in sync. with real time passing
-                                        assert(realTimeAtLastIdleTimerTick != -1);
-                                        assert(realTimeAtLastIdleTimerTick < realTimeNow);
-
-                                        qint64 realTimeElapsedSinceLastTick = realTimeNow - realTimeAtLastIdleTimerTick;
-
-                                        fastForward(realTimeElapsedSinceLastTick);
-                                    }
-
-                                    fakedTimeAtLastIdleTimerTick = fakedMSSinceEpoch;
-                                    realTimeAtLastIdleTimerTick  = realTimeNow;
-                                }
-                                else
-                                {
-                                    assert(fakedTimeAtLastIdleTimerTick == -1);
-                                    assert(realTimeAtLastIdleTimerTick == -1);
-
-                                    // Generate timeout events for any timers that have become due in real time elapsed since last idle timer event
-                                    generateTimeoutEventforOverdueQTimers();
+                                    idleTimerTick(*domain);
                                 }
 
                                 // Schedule next idle processing event
-                                pQt5Core_QTimer_start(&idleTimer);
+                                armIdleTimer();
 
                              });
 
+        idleTimerRearmer = &idleTimerRearmerInstance;
+
         idleTimerConfigured = true;
     }
 
@@ -836,8 +5123,7 @@ static void setupIdleTimer(void)
     qAddPostRoutine(qApplicationTeardown);
 
     // Start <idleTimer> with real QT5Core QTimer::start() method
-    pQt5Core_QTimer_start(&idleTimer);
-
+    armIdleTimer();
 }
 
 // Call setupIdleTimer() from QCoreApplication constructor once it's got to point of being able to support registration of timers etc.
@@ -851,17 +5137,28 @@ static void qApplicationTeardown(void)
 
     // Opportunity to clean up/reset QtFakeTime
 
-    fakedTimeAtLastIdleTimerTick   = -1;
-    realTimeAtLastIdleTimerTick    = -1;
+    for (TimeDomain* domain : allTimeDomains())
+    {
+        domain->fakedTimeAtLastIdleTimerTick   = -1;
+        domain->realTimeAtLastIdleTimerTick    = -1;
+
+        // Timer schedules *SHOULD* be self maintaining, as every time we add a QTimer pointer to one we connect a cleanup lambda function
+        // to the timer's destroyed() signal.  This appeared to work reliably on a Ubuntu 20.04(/GCC9) test host, however on shift to
+        // Ubuntu 22.04(/GCC 11) occasionally have zombie pointers remaining in map at QApplication teardown, that trigger segmentation
+        // faults when referenced in QtFakeTime operations in subsequent tests.
+        for (const std::shared_ptr<TimerShard>& shard : allTimerShards(*domain))
+        {
+            QMutexLocker lock(&shard->mutex);
+
+            countActiveTimers(-static_cast<int64_t>(shard->schedule->size()));
+
+            shard->schedule->clear();
+            shard->scheduleChanged();
+            shard->skippedTicks.clear();
+        }
 
-    // <qElapsedTimerStartTimes> is problematic as QElapsedTimer doesn't have any destructor we can shim/hook to remove entries
-    // from the map as corresponding QElapsedTimer instances are destroyed, and thus tends to fill up with stale pointers.
-    // Opportunity to purge it here.
-    qElapsedTimerStartTimes.clear();
+        QWriteLocker lock(&domain->timerShardsLock);
 
-    // <qTimerDueTimes> *SHOULD* be self maintaining, as every time we add a QTimer pointer to it we connect a cleanup lambda function
-    // to the timer's destroyed() signal.  This appeared to work reliably on a Ubuntu 20.04(/GCC9) test host, however on shift to
-    // Ubuntu 22.04(/GCC 11) occasionally have zombie pointers remaining in map at QApplication teardown, that trigger segmentation
-    // faults when referenced in QtFakeTime operations in subsequent tests.
-    qTimerDueTimes.clear();
+        pruneTimerShards(*domain);
+    }
 }
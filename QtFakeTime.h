@@ -1,8 +1,14 @@
 #pragma once
 
+#include <array>
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <QDateTime>
 
+class QTimer;
+class QThread;
+
 // A faking library for Qt framework based application unit testing that shims libQt5Core.so library to allow faking of current date/time
 // and accelerated passing of time (with QTimer events generated along the way).
 //
@@ -13,14 +19,25 @@
 //  - QDateTime::currentDateTime/currentMSecsSinceEpoch
 //  - QTime::currentTime()
 //  - QElapsedTimer
+//  - QDeadlineTimer (on a faked monotonic clock, stepped forward by fastForward() but unaffected by set()/reset())
 //  - QTimer
+//  - QThread::sleep/msleep/usleep (fast-forwarding faked time when called on the main thread, otherwise parking the calling thread
+//    until faked time reaches its wake time)
+//  - Timed waits - QWaitCondition::wait(QMutex*, ...), QSemaphore::tryAcquire(), QMutex::tryLock(), QThread::wait() &
+//    QThreadPool::waitForDone() (timing out once faked time reaches their deadline)
+//  - Blocking I/O waits - QProcess, QAbstractSocket & QLocalSocket waitFor*() methods, QTcpServer/QLocalServer::waitForNewConnection()
+//    (likewise timing out on faked time, while still returning as soon as real I/O completes)
+//  - libc clock_gettime(), gettimeofday() & time(), optionally (see setFakeLibcClocks())
+//  - libc sleeps & timed waits, optionally (see setFakeLibcWaits())
 //
 // Classes it doesn't yet support (either too hard or I didn't need them)
 //
 //  - QBasicTimer
-//  - QDeadlineTimer
-//  - Thread & Async wait/sleep functions
+//  - QWaitCondition::wait(QReadWriteLock*, ...), QReadWriteLock::tryLockForRead/Write() & other async waits
 //  - QObject timer functions
+//
+// All functions are thread-safe.  Faked time may be read via. the shimmed Qt methods from any thread without locking, while calls to
+// set()/reset()/fastForward() made from different threads are serialised.
 
 namespace QtFakeTime
 {
@@ -31,10 +48,170 @@ namespace QtFakeTime
 void set(const QDateTime& time);
 void set(qint64 msSinceEpoch);
 
-// Reset faked time back to real chronological time, incrementing normally
+// Reset faked time back to real chronological time, incrementing normally (at rate 1.0).  Also picks up any change of local timezone
+// (e.g. of TZ) since faked local time was last read.
 void reset(void);
 
-// Fast-forward faked time <mS> into the future, generating QTimer::timeout() events as appropriate along the way.
+// Freeze/unfreeze faked time (unfrozen by default).  Frozen faked time only moves on explicit set()/fastForward() calls, rather than
+// also proceeding in lockstep with real time, so tests see exactly reproducible timing.  Has no effect while tracking real time.
+void setFrozen(bool frozen);
+
+// Time dilation, for running whole applications faster (or slower) than real time.  Unfrozen faked time proceeds at <rate> times real
+// time (1.0 by default), with time seen by all shimmed methods and QTimer timeouts dilated alike.  Setting a rate other than 1.0 while
+// tracking real time starts faking time from the current time.
+void setRate(double rate);
+
+// Lockstep statistics since rate was last set.  An achieved rate below that requested, a load approaching 1.0 (fraction of real time
+// spent generating timeouts) or a growing number of late ticks indicate the host can't keep up with the requested rate.
+struct RateStats
+{
+    double      requestedRate;
+    double      achievedRate;
+    double      load;
+    uint64_t    lateTicks;
+};
+
+RateStats rateStats(void);
+
+// Enable/disable auto-advance (disabled by default).  With auto-advance enabled, once every participating thread is blocked in a timed
+// wait or sleep faked time moves on by itself, to the earliest point any of them is due to wake (or the next QTimer due, if sooner), so
+// timeout paths run in next to no real time.  Participating threads are those that have waited or slept on faked time since
+// auto-advance was last enabled/disabled or time was last reset(), so a thread busy doing work others are waiting on, having not waited
+// itself since, won't hold time back.  Has no effect while tracking real time.
+void setAutoAdvance(bool enabled);
+
+// Fast-forward faked time <mS> into the future, generating QTimer::timeout() events as appropriate along the way.  Timeouts of timers
+// owned by other threads are generated on those threads, via. their event loops, with every thread done with timers due at one
+// faked time before time moves on.
 void fastForward(uint64_t mS);
 
+// Faked time is held to the nS, as seen by QElapsedTimer::nsecsElapsed().  Qt::PreciseTimer QTimers are due exactly their interval
+// after being started, other QTimers on the following whole mS.
+void fastForward(std::chrono::nanoseconds duration);
+
+// Step faked time straight to the next QTimer due (starting faking from current time if not already), generating timeouts for every
+// timer due at that point.  Returns false, leaving time as-is, if no QTimers are active.
+bool advanceToNextTimer(void);
+
+// Fast-forward faked time as fastForward() does, but only until <predicate> holds, for at most <maxMS>.  <predicate> is evaluated
+// before time moves at all, then after each batch of timeouts due at the same faked time (and events arising from them) have been
+// processed, with time left at the point it first holds.  Returns faked time consumed.
+uint64_t fastForwardUntil(const std::function<bool(void)>& predicate, uint64_t maxMS);
+std::chrono::nanoseconds fastForwardUntil(const std::function<bool(void)>& predicate, std::chrono::nanoseconds maxDuration);
+
+// Time domains - independent faked clocks, each with its own timers, allowing several simulated subsystems to run concurrently within
+// the one process.  Every thread is bound to a single domain (the default domain unless bound to another), and the faked time seen by
+// a thread, along with that of its QElapsedTimers & QTimers, is that of its domain.  Domains can be fast-forwarded independently of
+// one another, and in parallel from different threads.
+//
+// The set(), reset(), setFrozen(), setRate(), setAutoAdvance(), fastForward(), advanceToNextTimer() & fastForwardUntil() functions
+// above act on the calling thread's domain.
+class TimeDomain;
+
+// Create a new domain, initially tracking real time.  Domains remain valid for the lifetime of the process.
+TimeDomain* createTimeDomain(void);
+
+// Domain threads are bound to unless explicitly bound to another.
+TimeDomain* defaultTimeDomain(void);
+
+// Calling thread's domain.
+TimeDomain* timeDomain(void);
+
+// Bind <thread>, and hence the QTimers it owns, to <domain> (nullptr for default domain).  A thread should be bound before it starts
+// any QElapsedTimers or QTimers, as those already active remain in their original domain.
+void bindTimeDomain(QThread* thread, TimeDomain* domain);
+
+void set(TimeDomain* domain, const QDateTime& time);
+void set(TimeDomain* domain, qint64 msSinceEpoch);
+void reset(TimeDomain* domain);
+void fastForward(TimeDomain* domain, uint64_t mS);
+void fastForward(TimeDomain* domain, std::chrono::nanoseconds duration);
+bool advanceToNextTimer(TimeDomain* domain);
+uint64_t fastForwardUntil(TimeDomain* domain, const std::function<bool(void)>& predicate, uint64_t maxMS);
+std::chrono::nanoseconds fastForwardUntil(TimeDomain* domain, const std::function<bool(void)>& predicate, std::chrono::nanoseconds maxDuration);
+void setFrozen(TimeDomain* domain, bool frozen);
+void setRate(TimeDomain* domain, double rate);
+void setAutoAdvance(TimeDomain* domain, bool enabled);
+RateStats rateStats(TimeDomain* domain);
+
+// Enable/disable batched timeouts (disabled by default).  By default fastForward() processes pending events after each individual
+// QTimer::timeout().  With batching enabled all timers due at the same instant time out in turn (in the order they were started),
+// followed by a single round of event processing.
+void setBatchedTimeouts(bool enabled);
+
+// Enable/disable faking of libc clocks (both disabled by default), for code reading the clock directly rather than via. Qt.  With
+// <realtime> enabled CLOCK_REALTIME, gettimeofday() & time() return the calling thread's domain's faked time, and with <monotonic>
+// enabled CLOCK_MONOTONIC follows its faked monotonic clock.  Calls made from within libQt5Core.so itself continue to see real time.
+void setFakeLibcClocks(bool realtime, bool monotonic);
+
+// Enable/disable faking of libc sleeps & timed waits (disabled by default) - nanosleep(), clock_nanosleep(), usleep(), sleep(), poll(),
+// epoll_wait(), select() & pthread_cond_timedwait()/clockwait() (hence std::this_thread::sleep_for() & std::condition_variable).  While
+// faking time these behave as QThread sleeps & timed waits do, sleeps on the main thread fast-forwarding time and other sleeps & waits
+// timing out on faked time (moved on by auto-advance, if enabled).  Calls made from within libQt5Core.so itself are left as-is.
+void setFakeLibcWaits(bool enabled);
+
+// Skip-ahead for repeating QTimers whose individual ticks are of no interest to test code (e.g. watchdog, polling or housekeeping
+// timers in long soak simulations).  Rather than timing out once per interval, a skip-ahead timer that would tick multiple times
+// during a fastForward() has all but the last of those ticks skipped, with the remaining tick generated in due order.
+//
+// Enable/disable skip-ahead for an individual timer, overriding any objectName pattern match.
+void setSkipAhead(QTimer* timer, bool enabled);
+
+// Enable skip-ahead for timers with objectName matching wildcard <objectNamePattern> (e.g. "heartbeat*").
+void setSkipAhead(const QString& objectNamePattern);
+
+// Disable skip-ahead for all timers and objectName patterns.
+void clearSkipAhead(void);
+
+// Optional handler notified of number of ticks skipped by a skip-ahead timer, called immediately before the timer's next timeout().
+using SkippedTicksHandler = std::function<void(QTimer* timer, uint64_t skippedTicks)>;
+void setSkippedTicksHandler(SkippedTicksHandler handler);
+
+// Histogram of how late (in real time) QTimer timeouts have been generated while tracking real time, rather than faking it.  Bucket 0
+// counts timeouts under 1mS late, bucket n those between 2^(n-1) and 2^n mS late, with the final bucket also counting anything later.
+constexpr int latenessHistogramBuckets = 12;
+
+std::array<uint64_t, latenessHistogramBuckets> latenessHistogram(void);
+void resetLatenessHistogram(void);
+
+// Scheduler statistics since process start (or last resetStats()), e.g. for tracking the speedup over real time fast-forwarding
+// achieves (<fastForwardedMS> vs. <fastForwardRealNS>), or spotting QTimers leaking in long runs (<activeTimers> growing).  Counted
+// per thread, so cheap enough to be left on.
+struct Stats
+{
+    uint64_t    timeouts;               // QTimer timeouts generated
+    uint64_t    eventPumps;             // Rounds of event processing run by fastForward()
+    uint64_t    activeTimers;           // QTimers currently active
+    uint64_t    peakActiveTimers;       // Most QTimers active at once
+    uint64_t    elapsedTimerStarts;     // QElapsedTimer start()/restart() calls
+    uint64_t    clockReads;             // Clock reads via. shimmed Qt methods (and faked libc clocks)
+    uint64_t    fastForwardedMS;        // Faked time moved on by fastForward() & faked sleeps/waits (not lockstep with real time)
+    uint64_t    fastForwardRealNS;      // Real time spent moving faked time on as above
+};
+
+Stats stats(void);
+void resetStats(void);
+
+// Timeline tracing (disabled by default), for seeing where the real time taken by a slow fastForward() goes.  While tracing, every
+// fastForward() call and QTimer timeout is recorded along with its faked & real start/end times, in a ring buffer of the most recent
+// <records> of them preallocated on starting.  Starting a trace discards any previously recorded.
+void startTrace(size_t records = 65536);
+void stopTrace(void);
+
+// Write recorded trace to <fileName> as Chrome trace event JSON (viewable in chrome://tracing or Perfetto), with faked and real
+// timelines side by side - a process per time domain's faked time plus one for real time, each with a track per thread.  Returns false
+// if the file couldn't be written.
+bool writeChromeTrace(const QString& fileName);
+
+// Data structure used to track active QTimers.  The binary heap suits most uses, the hierarchical timing wheel has lower cost per
+// timer start/stop/timeout once there are very large numbers (10^5 or more) of active timers.
+enum class TimerStore
+{
+    Heap,
+    TimingWheel
+};
+
+// Switch to tracking active QTimers with specified data structure (default TimerStore::Heap), currently active timers are carried over.
+void setTimerStore(TimerStore store);
+
 }
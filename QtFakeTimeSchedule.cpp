@@ -0,0 +1,567 @@
+#include "QtFakeTimeSchedule.h"
+
+#include <algorithm>
+#include <cassert>
+
+using namespace QtFakeTime;
+
+//------------------------------------------------------------------------------------------------------------------------
+// HeapTimerSchedule
+
+void HeapTimerSchedule::schedule(QTimer* timer, qint64 dueTime)
+{
+    auto ii = entries.find(timer);
+
+    if (ii == entries.end())
+    {
+        Entry& entry = entries[timer];
+
+        entry.timer     = timer;
+        entry.dueTime   = dueTime;
+        entry.sequence  = nextSequence++;
+
+        heap.push_back(&entry);
+        entry.heapIndex = heap.size() - 1;
+
+        siftUp(entry.heapIndex);
+    }
+    else
+    {
+        // Reschedule existing entry.  Issuing a new sequence number always moves entry later in ordering, so only a move to an
+        // earlier due time can require the entry to move towards the top of the heap.
+        Entry& entry = ii->second;
+
+        qint64 previousDueTime = entry.dueTime;
+
+        entry.dueTime   = dueTime;
+        entry.sequence  = nextSequence++;
+
+        if (dueTime < previousDueTime)
+        {
+            siftUp(entry.heapIndex);
+        }
+        else
+        {
+            siftDown(entry.heapIndex);
+        }
+    }
+}
+
+bool HeapTimerSchedule::cancel(const QTimer* timer)
+{
+    auto ii = entries.find(timer);
+
+    if (ii == entries.end())
+    {
+        return false;
+    }
+
+    size_t heapIndex = ii->second.heapIndex;
+
+    // Fill vacated slot with last entry in heap, which then needs to move up or down to restore heap ordering
+    Entry* last = heap.back();
+    heap.pop_back();
+
+    if (heapIndex < heap.size())
+    {
+        place(last, heapIndex);
+
+        siftUp(heapIndex);
+        siftDown(last->heapIndex);
+    }
+
+    entries.erase(ii);
+
+    return true;
+}
+
+bool HeapTimerSchedule::dueTime(const QTimer* timer, qint64& dueTime) const
+{
+    auto ii = entries.find(timer);
+
+    if (ii == entries.end())
+    {
+        return false;
+    }
+
+    dueTime = ii->second.dueTime;
+
+    return true;
+}
+
+QTimer* HeapTimerSchedule::next(qint64 limit, qint64* dueTime)
+{
+    if (heap.empty() || (heap.front()->dueTime > limit))
+    {
+        return nullptr;
+    }
+
+    if (dueTime != nullptr)
+    {
+        *dueTime = heap.front()->dueTime;
+    }
+
+    return heap.front()->timer;
+}
+
+bool HeapTimerSchedule::earliestDueTime(qint64& dueTime) const
+{
+    if (heap.empty())
+    {
+        return false;
+    }
+
+    dueTime = heap.front()->dueTime;
+
+    return true;
+}
+
+std::vector<QTimer*> HeapTimerSchedule::timers(void) const
+{
+    std::vector<QTimer*> result;
+
+    result.reserve(heap.size());
+
+    for (const Entry* entry : heap)
+    {
+        result.push_back(entry->timer);
+    }
+
+    return result;
+}
+
+void HeapTimerSchedule::clear(void)
+{
+    heap.clear();
+    entries.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+
+bool HeapTimerSchedule::before(const Entry* a, const Entry* b)
+{
+    if (a->dueTime != b->dueTime)
+    {
+        return a->dueTime < b->dueTime;
+    }
+
+    return a->sequence < b->sequence;
+}
+
+void HeapTimerSchedule::place(Entry* entry, size_t heapIndex)
+{
+    heap[heapIndex]     = entry;
+    entry->heapIndex    = heapIndex;
+}
+
+void HeapTimerSchedule::siftUp(size_t heapIndex)
+{
+    assert(heapIndex < heap.size());
+
+    Entry* entry = heap[heapIndex];
+
+    while (heapIndex > 0)
+    {
+        size_t parentIndex = (heapIndex - 1) / 2;
+
+        if (!before(entry, heap[parentIndex]))
+        {
+            break;
+        }
+
+        place(heap[parentIndex], heapIndex);
+        heapIndex = parentIndex;
+    }
+
+    place(entry, heapIndex);
+}
+
+void HeapTimerSchedule::siftDown(size_t heapIndex)
+{
+    assert(heapIndex < heap.size());
+
+    Entry* entry = heap[heapIndex];
+
+    while (true)
+    {
+        size_t childIndex = 2 * heapIndex + 1;
+
+        if (childIndex >= heap.size())
+        {
+            break;
+        }
+
+        if ((childIndex + 1 < heap.size()) && before(heap[childIndex + 1], heap[childIndex]))
+        {
+            ++childIndex;
+        }
+
+        if (!before(heap[childIndex], entry))
+        {
+            break;
+        }
+
+        place(heap[childIndex], heapIndex);
+        heapIndex = childIndex;
+    }
+
+    place(entry, heapIndex);
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+// WheelTimerSchedule
+
+constexpr int WheelTimerSchedule::levelBits;
+constexpr int WheelTimerSchedule::levels;
+constexpr int WheelTimerSchedule::slotsPerLevel;
+constexpr int WheelTimerSchedule::bitmapWords;
+
+WheelTimerSchedule::WheelTimerSchedule()
+{
+    clear();
+}
+
+void WheelTimerSchedule::schedule(QTimer* timer, qint64 dueTime)
+{
+    auto ii = entries.find(timer);
+
+    Entry* entry;
+
+    if (ii == entries.end())
+    {
+        entry = &entries[timer];
+        entry->timer = timer;
+    }
+    else
+    {
+        entry = &ii->second;
+        unlink(entry);
+    }
+
+    entry->dueTime  = dueTime;
+    entry->sequence = nextSequence++;
+
+    if (earliestCached && (dueTime < earliestCache))
+    {
+        earliestCache = dueTime;
+    }
+
+    if (key(dueTime) < wheelTime)
+    {
+        // Wheel can only hold timers due at or after its current time
+        rebuild();
+    }
+    else
+    {
+        place(entry);
+    }
+}
+
+bool WheelTimerSchedule::cancel(const QTimer* timer)
+{
+    auto ii = entries.find(timer);
+
+    if (ii == entries.end())
+    {
+        return false;
+    }
+
+    unlink(&ii->second);
+
+    entries.erase(ii);
+
+    return true;
+}
+
+bool WheelTimerSchedule::dueTime(const QTimer* timer, qint64& dueTime) const
+{
+    auto ii = entries.find(timer);
+
+    if (ii == entries.end())
+    {
+        return false;
+    }
+
+    dueTime = ii->second.dueTime;
+
+    return true;
+}
+
+QTimer* WheelTimerSchedule::next(qint64 limit, qint64* dueTime)
+{
+    if (entries.empty())
+    {
+        return nullptr;
+    }
+
+    const quint64 limitKey = key(limit);
+
+    while (true)
+    {
+        // Level 0 slots each hold timers for a single due time, in the order they were scheduled
+        int slot = firstOccupied(0, static_cast<int>(wheelTime & (slotsPerLevel - 1)));
+
+        if (slot >= 0)
+        {
+            Entry* entry = wheelSlots[0][slot].head;
+
+            if (key(entry->dueTime) > limitKey)
+            {
+                return nullptr;
+            }
+
+            if (dueTime != nullptr)
+            {
+                *dueTime = entry->dueTime;
+            }
+
+            return entry->timer;
+        }
+
+        // Nothing left at level 0, find earliest occupied slot of the lowest populated higher level and cascade its timers down
+        int level = 1;
+
+        for (; level < levels; ++level)
+        {
+            int cursor = static_cast<int>((wheelTime >> (level * levelBits)) & (slotsPerLevel - 1));
+
+            slot = firstOccupied(level, cursor + 1);
+
+            if (slot >= 0)
+            {
+                break;
+            }
+        }
+
+        assert(level < levels);
+
+        int     shift       = level * levelBits;
+        quint64 upperMask   = (shift + levelBits < 64) ? ~((1ULL << (shift + levelBits)) - 1) : 0;
+        quint64 slotStart   = (wheelTime & upperMask) | (static_cast<quint64>(slot) << shift);
+
+        if (slotStart > limitKey)
+        {
+            // Every remaining timer is due beyond <limit>, leave wheel time where it is
+            return nullptr;
+        }
+
+        wheelTime = slotStart;
+
+        cascade(level, slot);
+    }
+}
+
+bool WheelTimerSchedule::earliestDueTime(qint64& dueTime) const
+{
+    if (entries.empty())
+    {
+        return false;
+    }
+
+    if (!earliestCached)
+    {
+        const Entry* earliest = nullptr;
+
+        int slot = firstOccupied(0, static_cast<int>(wheelTime & (slotsPerLevel - 1)));
+
+        if (slot >= 0)
+        {
+            earliest = wheelSlots[0][slot].head;
+        }
+        else
+        {
+            // Earliest timers are in earliest occupied slot of lowest populated higher level, though in no particular order there
+            for (int level = 1; (earliest == nullptr) && (level < levels); ++level)
+            {
+                int cursor = static_cast<int>((wheelTime >> (level * levelBits)) & (slotsPerLevel - 1));
+
+                slot = firstOccupied(level, cursor + 1);
+
+                for (const Entry* entry = (slot >= 0) ? wheelSlots[level][slot].head : nullptr; entry != nullptr; entry = entry->next)
+                {
+                    if ((earliest == nullptr) || (entry->dueTime < earliest->dueTime))
+                    {
+                        earliest = entry;
+                    }
+                }
+            }
+        }
+
+        assert(earliest != nullptr);
+
+        earliestCache   = earliest->dueTime;
+        earliestCached  = true;
+    }
+
+    dueTime = earliestCache;
+
+    return true;
+}
+
+std::vector<QTimer*> WheelTimerSchedule::timers(void) const
+{
+    std::vector<QTimer*> result;
+
+    result.reserve(entries.size());
+
+    for (const auto& ii : entries)
+    {
+        result.push_back(ii.second.timer);
+    }
+
+    return result;
+}
+
+void WheelTimerSchedule::clear(void)
+{
+    entries.clear();
+
+    emptySlots();
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+
+void WheelTimerSchedule::place(Entry* entry)
+{
+    quint64 dueKey = key(entry->dueTime);
+
+    assert(dueKey >= wheelTime);
+
+    quint64 difference  = dueKey ^ wheelTime;
+    int level           = (difference == 0) ? 0 : (63 - __builtin_clzll(difference)) / levelBits;
+    int slot            = static_cast<int>((dueKey >> (level * levelBits)) & (slotsPerLevel - 1));
+
+    Slot& target = wheelSlots[level][slot];
+
+    entry->level    = static_cast<quint8>(level);
+    entry->slot     = static_cast<quint8>(slot);
+    entry->prev     = target.tail;
+    entry->next     = nullptr;
+
+    if (target.tail != nullptr)
+    {
+        target.tail->next = entry;
+    }
+    else
+    {
+        target.head = entry;
+        occupied[level][slot / 64] |= (1ULL << (slot % 64));
+    }
+
+    target.tail = entry;
+}
+
+void WheelTimerSchedule::unlink(Entry* entry)
+{
+    Slot& source = wheelSlots[entry->level][entry->slot];
+
+    if (entry->dueTime == earliestCache)
+    {
+        earliestCached = false;
+    }
+
+    if (entry->prev != nullptr)
+    {
+        entry->prev->next = entry->next;
+    }
+    else
+    {
+        source.head = entry->next;
+    }
+
+    if (entry->next != nullptr)
+    {
+        entry->next->prev = entry->prev;
+    }
+    else
+    {
+        source.tail = entry->prev;
+    }
+
+    if (source.head == nullptr)
+    {
+        occupied[entry->level][entry->slot / 64] &= ~(1ULL << (entry->slot % 64));
+    }
+}
+
+void WheelTimerSchedule::cascade(int level, int slot)
+{
+    // Wheel time has just advanced to start of <slot>'s span, with all lower levels empty.  Redistributing the slot's timers in list
+    // order therefore preserves scheduling order amongst timers sharing a due time.
+    Entry* entry = wheelSlots[level][slot].head;
+
+    wheelSlots[level][slot] = Slot();
+    occupied[level][slot / 64] &= ~(1ULL << (slot % 64));
+
+    while (entry != nullptr)
+    {
+        Entry* following = entry->next;
+
+        place(entry);
+
+        entry = following;
+    }
+}
+
+void WheelTimerSchedule::rebuild(void)
+{
+    // Re-place every timer relative to the earliest possible wheel time, in scheduling order so ties stay in order
+    std::vector<Entry*> ordered;
+
+    ordered.reserve(entries.size());
+
+    for (auto& ii : entries)
+    {
+        ordered.push_back(&ii.second);
+    }
+
+    std::sort(ordered.begin(), ordered.end(), [](const Entry* a, const Entry* b) {return a->sequence < b->sequence;});
+
+    emptySlots();
+
+    for (Entry* entry : ordered)
+    {
+        place(entry);
+    }
+}
+
+void WheelTimerSchedule::emptySlots(void)
+{
+    for (int level = 0; level < levels; ++level)
+    {
+        for (int slot = 0; slot < slotsPerLevel; ++slot)
+        {
+            wheelSlots[level][slot] = Slot();
+        }
+
+        for (int word = 0; word < bitmapWords; ++word)
+        {
+            occupied[level][word] = 0;
+        }
+    }
+
+    wheelTime = 0;
+
+    earliestCached = false;
+}
+
+int WheelTimerSchedule::firstOccupied(int level, int fromSlot) const
+{
+    for (int word = fromSlot / 64; word < bitmapWords; ++word)
+    {
+        quint64 bits = occupied[level][word];
+
+        if (word == fromSlot / 64)
+        {
+            // Mask off slots preceding <fromSlot>
+            bits &= ~0ULL << (fromSlot % 64);
+        }
+
+        if (bits != 0)
+        {
+            return word * 64 + __builtin_ctzll(bits);
+        }
+    }
+
+    return -1;
+}
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <QtGlobal>
+
+#include <unordered_map>
+#include <vector>
+
+class QTimer;
+
+namespace QtFakeTime
+{
+
+// Schedule of active faked QTimers, ordered by due time.  Timers due at the same time are ordered by the sequence in which they
+// were (re)scheduled, so firing order is deterministic rather than dependant on timer pointer values.
+class TimerSchedule
+{
+public:
+    virtual ~TimerSchedule() {}
+
+    // Add <timer> to the schedule or, if already scheduled, move it to <dueTime>.  In either case <timer> is placed behind any
+    // other timers already due at <dueTime>.
+    virtual void schedule(QTimer* timer, qint64 dueTime) = 0;
+
+    // Remove <timer> from the schedule, returning false if it wasn't scheduled.
+    virtual bool cancel(const QTimer* timer) = 0;
+
+    // Retrieve due time of <timer>, returning false if it isn't scheduled.
+    virtual bool dueTime(const QTimer* timer, qint64& dueTime) const = 0;
+
+    // Earliest due timer (along with it's due time if <dueTime> specified), or nullptr if no timer is due at or before <limit>.
+    // <limit> mustn't be beyond faked current time, as the schedule may reorganise itself up to the earliest timer due by then.
+    virtual QTimer* next(qint64 limit, qint64* dueTime = nullptr) = 0;
+
+    // Due time of earliest timer, returning false if no timer is scheduled.  Unlike next(), leaves the schedule as it is, so is
+    // used to look ahead beyond faked current time.
+    virtual bool earliestDueTime(qint64& dueTime) const = 0;
+
+    // Snapshot of all scheduled timers, in no particular order.
+    virtual std::vector<QTimer*> timers(void) const = 0;
+
+    virtual size_t size(void) const = 0;
+
+    virtual void clear(void) = 0;
+
+    bool contains(const QTimer* timer) const
+    {
+        qint64 unused;
+        return dueTime(timer, unused);
+    }
+
+    bool empty(void) const
+    {
+        return size() == 0;
+    }
+};
+
+// Binary min-heap of timer entries, with each entry recording its own position in the heap so that a timer can be started,
+// stopped or rescheduled in O(log n) without searching for it.
+class HeapTimerSchedule: public TimerSchedule
+{
+public:
+    void schedule(QTimer* timer, qint64 dueTime) override;
+    bool cancel(const QTimer* timer) override;
+    bool dueTime(const QTimer* timer, qint64& dueTime) const override;
+    QTimer* next(qint64 limit, qint64* dueTime = nullptr) override;
+    bool earliestDueTime(qint64& dueTime) const override;
+    std::vector<QTimer*> timers(void) const override;
+    size_t size(void) const override   {return heap.size();}
+    void clear(void) override;
+
+private:
+    struct Entry
+    {
+        QTimer* timer;
+        qint64  dueTime;
+        quint64 sequence;
+        size_t  heapIndex;
+    };
+
+    static bool before(const Entry* a, const Entry* b);
+
+    void place(Entry* entry, size_t heapIndex);
+    void siftUp(size_t heapIndex);
+    void siftDown(size_t heapIndex);
+
+    // Entries are node allocated, so pointers to them held in <heap> remain valid as other timers are added/removed.
+    std::unordered_map<const QTimer*, Entry> entries;
+    std::vector<Entry*> heap;
+
+    quint64 nextSequence = 0;
+};
+
+// Hierarchical timing wheel, giving amortised O(1) start/stop/expiry for very large timer populations.
+//
+// The wheel has 8 levels of 256 slots, each level covering 8 bits of a 64 bit due time, so no due time is out of range.  A timer
+// is held at the level of the most significant 8 bit digit in which its due time differs from the wheel's current time, in the
+// slot given by that digit.  Level 0 slots therefore hold timers for a single exact due time.  As the wheel's time advances into
+// the span of a higher level slot, its timers are cascaded down to lower levels, each timer cascading at most once per level.
+//
+// The wheel's time only advances as far as the <limit> passed to next(), which mustn't be beyond faked current time, so it never
+// overtakes it.  Looking further ahead is left to earliestDueTime(), which doesn't move the wheel.  Scheduling a timer earlier than
+// the wheel's time (only possible following a backwards jump in faked time) rebuilds the wheel.
+class WheelTimerSchedule: public TimerSchedule
+{
+public:
+    WheelTimerSchedule();
+
+    void schedule(QTimer* timer, qint64 dueTime) override;
+    bool cancel(const QTimer* timer) override;
+    bool dueTime(const QTimer* timer, qint64& dueTime) const override;
+    QTimer* next(qint64 limit, qint64* dueTime = nullptr) override;
+    bool earliestDueTime(qint64& dueTime) const override;
+    std::vector<QTimer*> timers(void) const override;
+    size_t size(void) const override   {return entries.size();}
+    void clear(void) override;
+
+private:
+    static constexpr int levelBits      = 8;
+    static constexpr int levels         = 64 / levelBits;
+    static constexpr int slotsPerLevel  = 1 << levelBits;
+    static constexpr int bitmapWords    = slotsPerLevel / 64;
+
+    struct Entry
+    {
+        QTimer* timer;
+        qint64  dueTime;
+        quint64 sequence;
+        Entry*  prev;
+        Entry*  next;
+        quint8  level;
+        quint8  slot;
+    };
+
+    struct Slot
+    {
+        Entry* head = nullptr;
+        Entry* tail = nullptr;
+    };
+
+    // Due times are held as unsigned keys, offset such that key ordering matches signed due time ordering
+    static quint64 key(qint64 time)     {return static_cast<quint64>(time) ^ 0x8000000000000000ULL;}
+
+    void place(Entry* entry);
+    void unlink(Entry* entry);
+    void cascade(int level, int slot);
+    void rebuild(void);
+    void emptySlots(void);
+
+    int firstOccupied(int level, int fromSlot) const;
+
+    std::unordered_map<const QTimer*, Entry> entries;
+
+    Slot    wheelSlots[levels][slotsPerLevel];
+    quint64 occupied[levels][bitmapWords];
+
+    quint64 wheelTime;
+
+    // Result of last earliestDueTime() look ahead, kept while no earlier timer is scheduled and none due at that time is removed,
+    // saving a search of a higher level slot on every call
+    mutable bool    earliestCached = false;
+    mutable qint64  earliestCache  = 0;
+
+    quint64 nextSequence = 0;
+};
+
+}
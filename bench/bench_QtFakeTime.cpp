@@ -0,0 +1,648 @@
+#include <QCoreApplication>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QProcess>
+#include <QProcessEnvironment>
+
+#include "QtFakeTime.h"
+#include "QtFakeTimeSchedule.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <map>
+#include <memory>
+#include <random>
+#include <vector>
+#include <algorithm>
+
+#include <dlfcn.h>
+#include <time.h>
+
+// Throughput benchmarks for QtFakeTime.  Reports timer timeouts fired per (real) second, both for the bare timer stores and
+// end-to-end through QtFakeTime::fastForward() with real QTimer instances under single-shot, repeating & mixed workloads, along with
+// per-call overhead of the shimmed Qt clock methods (against unshimmed libQt5Core) & libc clocks, cost of QTimer::singleShot() and of
+// set() sanitising active timers, and process startup time to first Qt call with & without the preload.
+//
+// Results are also written as JSON to the file given by "--json <file>", so scheduler regressions can be caught by comparing runs.
+
+using Clock = std::chrono::steady_clock;
+
+static double secondsSince(Clock::time_point start)
+{
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+// Machine readable results, every figure reported recorded along with the benchmark & case it belongs to
+
+struct Result
+{
+    std::string benchmark;
+    std::string variant;
+    std::string unit;
+    double      value;
+};
+
+static std::vector<Result> results;
+
+static double record(const char* benchmark, const std::string& variant, const char* unit, double value)
+{
+    results.push_back({benchmark, variant, unit, value});
+
+    return value;
+}
+
+static bool writeResults(const char* fileName)
+{
+    FILE* file = fopen(fileName, "w");
+
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    fprintf(file, "{\n    \"results\": [\n");
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        fprintf(file,
+                "        {\"benchmark\": \"%s\", \"case\": \"%s\", \"unit\": \"%s\", \"value\": %.3f}%s\n",
+                results[i].benchmark.c_str(),
+                results[i].variant.c_str(),
+                results[i].unit.c_str(),
+                results[i].value,
+                (i + 1 < results.size()) ? "," : "");
+    }
+
+    fprintf(file, "    ]\n}\n");
+
+    return fclose(file) == 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+// Timer store benchmarks, firing repeating "timers" directly against the store with no Qt involvement.  Timers are represented by
+// arbitrary distinct pointer values, which the stores never dereference.
+
+static QTimer* fakeTimer(size_t index)
+{
+    return reinterpret_cast<QTimer*>((index + 1) * 16);
+}
+
+static std::vector<qint64> randomIntervals(size_t timerCount)
+{
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<qint64> intervalDistribution(10, 10000);
+
+    std::vector<qint64> intervals(timerCount);
+
+    for (qint64& interval : intervals)
+    {
+        interval = intervalDistribution(rng);
+    }
+
+    return intervals;
+}
+
+// Reference implementation of the original std::map based store, scanning for earliest due timer on every timeout.
+static double mapFiresPerSecond(size_t timerCount, uint64_t fires)
+{
+    std::vector<qint64> intervals = randomIntervals(timerCount);
+    std::map<QTimer*, qint64> dueTimes;
+    std::map<QTimer*, qint64> timerIntervals;
+
+    for (size_t i = 0; i < timerCount; ++i)
+    {
+        dueTimes[fakeTimer(i)]          = intervals[i];
+        timerIntervals[fakeTimer(i)]    = intervals[i];
+    }
+
+    Clock::time_point start = Clock::now();
+
+    for (uint64_t i = 0; i < fires; ++i)
+    {
+        auto ii = std::min_element( dueTimes.begin(),
+                                    dueTimes.end(),
+                                    [](const std::pair<QTimer* const, qint64>& a, const std::pair<QTimer* const, qint64>& b)
+                                    {
+                                        return a.second < b.second;
+                                    });
+
+        ii->second += timerIntervals[ii->first];
+    }
+
+    return fires / secondsSince(start);
+}
+
+static double scheduleFiresPerSecond(QtFakeTime::TimerSchedule& schedule, size_t timerCount, uint64_t fires)
+{
+    std::vector<qint64> intervals = randomIntervals(timerCount);
+
+    for (size_t i = 0; i < timerCount; ++i)
+    {
+        schedule.schedule(fakeTimer(i), intervals[i]);
+    }
+
+    Clock::time_point start = Clock::now();
+
+    // Simulated faked current time, moved on to each timeout in turn as fastForward() does, since next() mustn't look beyond it
+    qint64 timeNow = 0;
+
+    for (uint64_t i = 0; i < fires; ++i)
+    {
+        qint64 timeDue;
+        QTimer* timer = schedule.next(timeNow, &timeDue);
+
+        if (timer == nullptr)
+        {
+            schedule.earliestDueTime(timeNow);
+
+            timer = schedule.next(timeNow, &timeDue);
+        }
+
+        size_t index = reinterpret_cast<size_t>(timer) / 16 - 1;
+
+        schedule.schedule(timer, timeDue + intervals[index]);
+    }
+
+    return fires / secondsSince(start);
+}
+
+static void benchmarkTimerStores(void)
+{
+    printf("Timer store timeouts/sec (repeating timers, 10-10000mS intervals)\n");
+    printf("%10s %16s %16s %16s\n", "timers", "std::map", "heap", "timing wheel");
+
+    for (size_t timerCount : {1000, 100000, 1000000})
+    {
+        // Bound the number of timeouts fired through the (O(n) per timeout) std::map reference so it completes in reasonable time
+        uint64_t fires      = 2000000;
+        uint64_t mapFires   = std::min<uint64_t>(fires, 200000000 / timerCount);
+
+        QtFakeTime::HeapTimerSchedule heap;
+        std::unique_ptr<QtFakeTime::WheelTimerSchedule> wheel(new QtFakeTime::WheelTimerSchedule());
+
+        std::string variant = std::to_string(timerCount) + " timers";
+
+        printf("%10zu %16.0f %16.0f %16.0f\n",
+               timerCount,
+               record("timer store std::map", variant, "timeouts/sec", mapFiresPerSecond(timerCount, mapFires)),
+               record("timer store heap", variant, "timeouts/sec", scheduleFiresPerSecond(heap, timerCount, fires)),
+               record("timer store timing wheel", variant, "timeouts/sec", scheduleFiresPerSecond(*wheel, timerCount, fires)));
+    }
+
+    printf("\n");
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+// End-to-end benchmarks, fast-forwarding real (shimmed) QTimer instances.
+
+// Single-shot timers are restarted from their own timeout (as timeouts/retries typically are), so that every workload keeps the same
+// number of timers active throughout
+enum class Workload
+{
+    SingleShot,
+    Repeating,
+    Mixed
+};
+
+static const char* workloadName(Workload workload)
+{
+    switch (workload)
+    {
+        case Workload::SingleShot:  return "single-shot";
+        case Workload::Repeating:   return "repeating";
+        case Workload::Mixed:       return "mixed";
+    }
+
+    return "";
+}
+
+static double fastForwardFiresPerSecond(QtFakeTime::TimerStore store, Workload workload, size_t timerCount, uint64_t fastForwardMS)
+{
+    QtFakeTime::setTimerStore(store);
+    QtFakeTime::set(QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate));
+
+    std::vector<qint64> intervals = randomIntervals(timerCount);
+    std::vector<std::unique_ptr<QTimer>> timers;
+
+    uint64_t fires = 0;
+
+    timers.reserve(timerCount);
+
+    for (size_t i = 0; i < timerCount; ++i)
+    {
+        QTimer* timer = new QTimer();
+
+        timers.emplace_back(timer);
+
+        bool singleShot = (workload == Workload::SingleShot) || ((workload == Workload::Mixed) && (i % 2 == 0));
+
+        timer->setSingleShot(singleShot);
+        timer->setInterval(static_cast<int>(intervals[i]));
+
+        if (singleShot)
+        {
+            QObject::connect(timer, &QTimer::timeout, [&fires, timer](){++fires; timer->start();});
+        }
+        else
+        {
+            QObject::connect(timer, &QTimer::timeout, [&fires](){++fires;});
+        }
+
+        timer->start();
+    }
+
+    Clock::time_point start = Clock::now();
+
+    QtFakeTime::fastForward(fastForwardMS);
+
+    double firesPerSecond = fires / secondsSince(start);
+
+    timers.clear();
+
+    QtFakeTime::reset();
+
+    return firesPerSecond;
+}
+
+static void benchmarkFastForward(void)
+{
+    printf("QtFakeTime::fastForward() timeouts/sec (QTimers, 10-10000mS intervals)\n");
+    printf("%10s %12s %16s %16s\n", "timers", "workload", "heap", "timing wheel");
+
+    for (size_t timerCount : {1, 1000, 100000, 1000000})
+    {
+        for (Workload workload : {Workload::SingleShot, Workload::Repeating, Workload::Mixed})
+        {
+            // Scale fast-forward period so each case fires roughly the same number of timeouts
+            uint64_t fastForwardMS = 2000000000ULL / timerCount;
+
+            std::string variant = std::to_string(timerCount) + " timers, " + workloadName(workload);
+
+            printf("%10zu %12s %16.0f %16.0f\n",
+                   timerCount,
+                   workloadName(workload),
+                   record("fastForward heap", variant, "timeouts/sec",
+                          fastForwardFiresPerSecond(QtFakeTime::TimerStore::Heap, workload, timerCount, fastForwardMS)),
+                   record("fastForward timing wheel", variant, "timeouts/sec",
+                          fastForwardFiresPerSecond(QtFakeTime::TimerStore::TimingWheel, workload, timerCount, fastForwardMS)));
+        }
+    }
+
+    QtFakeTime::setTimerStore(QtFakeTime::TimerStore::Heap);
+
+    printf("\n");
+}
+
+static void benchmarkSingleShot(void)
+{
+    // QTimer::singleShot() allocates (and on timeout deletes) a QTimer per call
+    const int calls = 100000;
+
+    QtFakeTime::set(QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate));
+
+    uint64_t fires = 0;
+
+    Clock::time_point start = Clock::now();
+
+    for (int i = 0; i < calls; ++i)
+    {
+        QTimer::singleShot(1 + i % 1000, [&fires](){++fires;});
+    }
+
+    double startNS = secondsSince(start) * 1e9 / calls;
+
+    start = Clock::now();
+
+    QtFakeTime::fastForward(1000);
+
+    double timeoutNS = secondsSince(start) * 1e9 / std::max<uint64_t>(fires, 1);
+
+    QtFakeTime::reset();
+
+    printf("QTimer::singleShot() nS/call\n");
+    printf("%-36s %10.1f\n", "singleShot()", record("QTimer::singleShot", "start", "nS/call", startNS));
+    printf("%-36s %10.1f\n", "timeout (incl. deletion)", record("QTimer::singleShot", "timeout", "nS/call", timeoutNS));
+
+    printf("\n");
+}
+
+static double setMSPerCall(size_t timerCount, qint64 jumpMS, int calls)
+{
+    // Each set() moves faked time on by <jumpMS>, with <timerCount> repeating timers active for set() to sanitise
+    qint64 msSinceEpoch = QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate).toMSecsSinceEpoch();
+
+    QtFakeTime::set(msSinceEpoch);
+
+    std::vector<qint64> intervals = randomIntervals(timerCount);
+    std::vector<std::unique_ptr<QTimer>> timers;
+
+    for (size_t i = 0; i < timerCount; ++i)
+    {
+        timers.emplace_back(new QTimer());
+        timers.back()->start(static_cast<int>(intervals[i]));
+    }
+
+    Clock::time_point start = Clock::now();
+
+    for (int i = 0; i < calls; ++i)
+    {
+        msSinceEpoch += jumpMS;
+
+        QtFakeTime::set(msSinceEpoch);
+    }
+
+    double msPerCall = secondsSince(start) * 1e3 / calls;
+
+    timers.clear();
+
+    QtFakeTime::reset();
+
+    return msPerCall;
+}
+
+static void benchmarkSet(void)
+{
+    // Small jumps leave active timers be (bar timing out those now overdue), while jumps well beyond their intervals restart them
+    const qint64 dayMS = 24 * 60 * 60 * 1000;
+
+    printf("QtFakeTime::set() mS/call (repeating QTimers, 10-10000mS intervals)\n");
+    printf("%10s %16s %16s\n", "timers", "100mS jump", "1 day jump");
+
+    for (size_t timerCount : {1000, 100000})
+    {
+        std::string variant = std::to_string(timerCount) + " timers, ";
+
+        int calls = (timerCount > 1000) ? 20 : 200;
+
+        printf("%10zu %16.3f %16.3f\n",
+               timerCount,
+               record("set", variant + "100mS jump", "mS/call", setMSPerCall(timerCount, 100, calls)),
+               record("set", variant + "1 day jump", "mS/call", setMSPerCall(timerCount, dayMS, calls)));
+    }
+
+    printf("\n");
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+// Qt clock method & libc clock per-call overhead.  Being preloaded, the shims can't be bypassed by name from within this executable, so
+// unshimmed baselines are looked up via. the handles of libQt5Core/libc themselves, which find their own definitions ahead of the
+// preloaded ones.
+
+template<typename Function>
+static Function unshimmed(const char* library, const char* symbol)
+{
+    void* handle = dlopen(library, RTLD_LAZY | RTLD_NOLOAD);
+
+    return reinterpret_cast<Function>(dlsym(handle, symbol));
+}
+
+using ClockGettime = int (*)(clockid_t, struct timespec*);
+
+static ClockGettime libcClockGettime(void)
+{
+    return unshimmed<ClockGettime>("libc.so.6", "clock_gettime");
+}
+
+static double clockNSPerCall(ClockGettime clockGettime, clockid_t clockId, uint64_t calls)
+{
+    struct timespec ts;
+    qint64 sum = 0;
+
+    Clock::time_point start = Clock::now();
+
+    for (uint64_t i = 0; i < calls; ++i)
+    {
+        clockGettime(clockId, &ts);
+        sum += ts.tv_nsec;
+    }
+
+    double nsPerCall = secondsSince(start) * 1e9 / calls;
+
+    // Stop loop being optimised away
+    if (sum == 42)
+    {
+        printf(" ");
+    }
+
+    return nsPerCall;
+}
+
+static double nsPerCall(qint64 (* call)(void), uint64_t calls)
+{
+    qint64 sum = 0;
+
+    Clock::time_point start = Clock::now();
+
+    for (uint64_t i = 0; i < calls; ++i)
+    {
+        sum += call();
+    }
+
+    double nsPerCall = secondsSince(start) * 1e9 / calls;
+
+    if (sum == 42)
+    {
+        printf(" ");
+    }
+
+    return nsPerCall;
+}
+
+static QElapsedTimer shimmedElapsedTimer;
+static QElapsedTimer unshimmedElapsedTimer;
+
+static void benchmarkQtClockMethods(void)
+{
+    const uint64_t calls = 1000000;
+    const char* qtCore = "libQt5Core.so.5";
+
+    static auto currentDateTime         = unshimmed<QDateTime (*)(void)>(qtCore, "_ZN9QDateTime15currentDateTimeEv");
+    static auto currentDateTimeUtc      = unshimmed<QDateTime (*)(void)>(qtCore, "_ZN9QDateTime18currentDateTimeUtcEv");
+    static auto currentMSecsSinceEpoch  = unshimmed<qint64 (*)(void)>(qtCore, "_ZN9QDateTime22currentMSecsSinceEpochEv");
+    static auto currentSecsSinceEpoch   = unshimmed<qint64 (*)(void)>(qtCore, "_ZN9QDateTime21currentSecsSinceEpochEv");
+    static auto currentTime             = unshimmed<QTime (*)(void)>(qtCore, "_ZN5QTime11currentTimeEv");
+    static auto elapsedTimerStart       = unshimmed<void (*)(QElapsedTimer*)>(qtCore, "_ZN13QElapsedTimer5startEv");
+    static auto elapsedTimerNsecs       = unshimmed<qint64 (*)(const QElapsedTimer*)>(qtCore, "_ZNK13QElapsedTimer12nsecsElapsedEv");
+
+    struct ClockMethod
+    {
+        const char* name;
+        qint64 (* shimmed)(void);
+        qint64 (* unshimmed)(void);
+    };
+
+    const ClockMethod methods[] =
+    {
+        {
+            "QDateTime::currentDateTime()",
+            []() -> qint64 {return QDateTime::currentDateTime().time().msec();},
+            []() -> qint64 {return currentDateTime().time().msec();}
+        },
+        {
+            "QDateTime::currentDateTimeUtc()",
+            []() -> qint64 {return QDateTime::currentDateTimeUtc().time().msec();},
+            []() -> qint64 {return currentDateTimeUtc().time().msec();}
+        },
+        {
+            "QDateTime::currentMSecsSinceEpoch()",
+            []() -> qint64 {return QDateTime::currentMSecsSinceEpoch();},
+            []() -> qint64 {return currentMSecsSinceEpoch();}
+        },
+        {
+            "QDateTime::currentSecsSinceEpoch()",
+            []() -> qint64 {return QDateTime::currentSecsSinceEpoch();},
+            []() -> qint64 {return currentSecsSinceEpoch();}
+        },
+        {
+            "QTime::currentTime()",
+            []() -> qint64 {return QTime::currentTime().msec();},
+            []() -> qint64 {return currentTime().msec();}
+        },
+        {
+            "QElapsedTimer::start()",
+            []() -> qint64 {shimmedElapsedTimer.start(); return 0;},
+            []() -> qint64 {elapsedTimerStart(&unshimmedElapsedTimer); return 0;}
+        },
+        {
+            "QElapsedTimer::nsecsElapsed()",
+            []() -> qint64 {return shimmedElapsedTimer.nsecsElapsed();},
+            []() -> qint64 {return elapsedTimerNsecs(&unshimmedElapsedTimer);}
+        }
+    };
+
+    printf("Qt clock methods nS/call\n");
+    printf("%-36s %12s %12s %12s\n", "", "unshimmed", "real time", "faked time");
+
+    elapsedTimerStart(&unshimmedElapsedTimer);
+
+    for (const ClockMethod& method : methods)
+    {
+        printf("%-36s %12.1f", method.name, record(method.name, "unshimmed", "nS/call", nsPerCall(method.unshimmed, calls)));
+
+        QtFakeTime::reset();
+        shimmedElapsedTimer.start();
+        printf(" %12.1f", record(method.name, "shimmed, real time", "nS/call", nsPerCall(method.shimmed, calls)));
+
+        QtFakeTime::set(QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate));
+        shimmedElapsedTimer.start();
+        printf(" %12.1f\n", record(method.name, "shimmed, faked time", "nS/call", nsPerCall(method.shimmed, calls)));
+
+        QtFakeTime::reset();
+    }
+
+    printf("\n");
+}
+
+static void benchmarkLibcClocks(void)
+{
+    const uint64_t calls = 10000000;
+
+    // Only CLOCK_REALTIME is faked, leaving the steady clock timing the benchmark running in real time
+    printf("clock_gettime(CLOCK_REALTIME) nS/call\n");
+    const char* benchmark = "clock_gettime(CLOCK_REALTIME)";
+
+    printf("%-36s %10.1f\n", "libc (unshimmed baseline)",
+           record(benchmark, "unshimmed", "nS/call", clockNSPerCall(libcClockGettime(), CLOCK_REALTIME, calls)));
+    printf("%-36s %10.1f\n", "shimmed, libc clocks not faked",
+           record(benchmark, "shimmed, not faked", "nS/call", clockNSPerCall(clock_gettime, CLOCK_REALTIME, calls)));
+
+    QtFakeTime::setFakeLibcClocks(true, false);
+    printf("%-36s %10.1f\n", "shimmed, real time",
+           record(benchmark, "shimmed, real time", "nS/call", clockNSPerCall(clock_gettime, CLOCK_REALTIME, calls)));
+
+    QtFakeTime::set(QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate));
+    printf("%-36s %10.1f\n", "shimmed, faked time",
+           record(benchmark, "shimmed, faked time", "nS/call", clockNSPerCall(clock_gettime, CLOCK_REALTIME, calls)));
+
+    QtFakeTime::reset();
+    QtFakeTime::setFakeLibcClocks(false, false);
+
+    printf("\n");
+}
+
+//------------------------------------------------------------------------------------------------------------------------
+// Process startup, timed from launching bench_first_qt_call probe to its first Qt call returning.
+
+static double firstQtCallMS(bool preload, int runs)
+{
+    QProcessEnvironment environment = QProcessEnvironment::systemEnvironment();
+
+    if (!preload)
+    {
+        environment.remove("LD_PRELOAD");
+    }
+
+    QString probe = QCoreApplication::applicationDirPath() + "/bench_first_qt_call";
+
+    double totalMS = 0;
+
+    for (int run = 0; run < runs; ++run)
+    {
+        QProcess process;
+
+        process.setProcessEnvironment(environment);
+
+        struct timespec ts;
+
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+
+        qint64 launchTime = static_cast<qint64>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+
+        process.start(probe, QStringList());
+
+        if (!process.waitForFinished() || (process.exitCode() != 0))
+        {
+            printf("Couldn't run %s\n", qPrintable(probe));
+            return 0;
+        }
+
+        totalMS += (process.readAllStandardOutput().trimmed().toLongLong() - launchTime) / 1e6;
+    }
+
+    return totalMS / runs;
+}
+
+static void benchmarkStartup(void)
+{
+    const int runs = 50;
+
+    printf("Time to first Qt call (mS)\n");
+    printf("%-36s %10.2f\n", "without preload", record("startup", "without preload", "mS", firstQtCallMS(false, runs)));
+    printf("%-36s %10.2f\n", "with preload", record("startup", "with preload", "mS", firstQtCallMS(true, runs)));
+
+    printf("\n");
+}
+
+int main(int argc, char** argv)
+{
+    QCoreApplication application(argc, argv);
+
+    const char* jsonFileName = nullptr;
+
+    for (int i = 1; i + 1 < argc; ++i)
+    {
+        if (strcmp(argv[i], "--json") == 0)
+        {
+            jsonFileName = argv[i + 1];
+        }
+    }
+
+    benchmarkTimerStores();
+    benchmarkFastForward();
+    benchmarkSingleShot();
+    benchmarkSet();
+    benchmarkQtClockMethods();
+    benchmarkLibcClocks();
+    benchmarkStartup();
+
+    if ((jsonFileName != nullptr) && !writeResults(jsonFileName))
+    {
+        printf("Couldn't write %s\n", jsonFileName);
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,21 @@
+#include <QDateTime>
+
+#include <cstdio>
+
+#include <time.h>
+
+// Startup probe run by bench_QtFakeTime, with & without libQtFakeTime.so preloaded.  Reports real monotonic clock time (nS) at which
+// its first Qt call returns.
+
+int main(void)
+{
+    QDateTime::currentMSecsSinceEpoch();
+
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    printf("%lld\n", static_cast<long long>(ts.tv_sec) * 1000000000LL + ts.tv_nsec);
+
+    return 0;
+}
@@ -4,12 +4,35 @@
 #include <QTime>
 #include <QThread>
 #include <QElapsedTimer>
+#include <QDeadlineTimer>
 #include <QTimer>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QSemaphore>
+#include <QProcess>
 #include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
 
 
 #include "QtFakeTime.h"
 
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/time.h>
+#include <time.h>
+
 using ::testing::Test;
 
 class QtFakeTimeTests : public Test
@@ -27,6 +50,14 @@ protected:
     virtual void SetUp()
     {
         QtFakeTime::reset();
+        QtFakeTime::setFakeLibcClocks(false, false);
+        QtFakeTime::setFakeLibcWaits(false);
+        QtFakeTime::setFrozen(false);
+        QtFakeTime::setAutoAdvance(false);
+        QtFakeTime::setBatchedTimeouts(false);
+        QtFakeTime::setTimerStore(QtFakeTime::TimerStore::Heap);
+        QtFakeTime::clearSkipAhead();
+        QtFakeTime::setSkippedTicksHandler(nullptr);
     }
 
     virtual void TearDown()
@@ -45,6 +76,19 @@ void WaitWhileProcessingEvents(int wait_time_ms)
     }
 }
 
+// As WaitWhileProcessingEvents(), but waiting on real time, for while faked time is frozen or running at other than real time rate.
+// NOTE: steady_clock reads are only real while libc clocks aren't being faked.
+void WaitRealTimeWhileProcessingEvents(int wait_time_ms)
+{
+    std::chrono::steady_clock::time_point end_time = std::chrono::steady_clock::now() + std::chrono::milliseconds(wait_time_ms);
+    while (std::chrono::steady_clock::now() < end_time)
+    {
+        QThread::yieldCurrentThread();
+
+        QCoreApplication::processEvents();
+    }
+}
+
 TEST_F(QtFakeTimeTests, QDateTime_currentDateTime)
 {
     // Confirm that QDateTime::currentDateTime() reflects fast-forward of time
@@ -156,6 +200,59 @@ TEST_F(QtFakeTimeTests, QDateTime_currentSecsSinceEpoch)
     ASSERT_EQ(t2, t1 + 5);
 }
 
+TEST_F(QtFakeTimeTests, QDateTime_currentDateTime_and_QTime_currentTime_match_local_time_conversion_throughout_year)
+{
+    // Faked local time derived from cached UTC offset must agree with Qt's own conversion, either side of DST transitions (in a zone
+    // pinned to have some, whatever the machine's own zone)
+    struct PinnedTimeZone
+    {
+        QByteArray savedTZ  = qgetenv("TZ");
+        bool hadTZ          = qEnvironmentVariableIsSet("TZ");
+
+        PinnedTimeZone()
+        {
+            qputenv("TZ", "Europe/London");
+            tzset();
+        }
+
+        ~PinnedTimeZone()
+        {
+            if (hadTZ)
+            {
+                qputenv("TZ", savedTZ);
+            }
+            else
+            {
+                qunsetenv("TZ");
+            }
+
+            tzset();
+
+            QtFakeTime::reset();
+        }
+    } pinnedTimeZone;
+
+    QtFakeTime::reset();
+    QtFakeTime::setFrozen(true);
+
+    qint64 msSinceEpoch = QDateTime::fromString("2022-01-01T00:00:00Z", Qt::ISODate).toMSecsSinceEpoch();
+
+    for (int step = 0; step < 24 * 365; ++step)
+    {
+        msSinceEpoch += 60 * 60 * 1000 + 1;
+
+        QtFakeTime::set(msSinceEpoch);
+
+        QDateTime expected = QDateTime::fromMSecsSinceEpoch(msSinceEpoch);
+        QDateTime faked = QDateTime::currentDateTime();
+
+        ASSERT_EQ(expected, faked);
+        ASSERT_EQ(expected.toString(Qt::ISODateWithMs), faked.toString(Qt::ISODateWithMs));
+        ASSERT_EQ(expected.offsetFromUtc(), faked.offsetFromUtc());
+        ASSERT_EQ(expected.time(), QTime::currentTime());
+    }
+}
+
 TEST_F(QtFakeTimeTests, QTime_currentTime)
 {
     // Confirm that QTime::currentTime() reflects fast-forward of time
@@ -247,6 +344,131 @@ TEST_F(QtFakeTimeTests, QElapsedTimer_restarted_on_big_backwards_jump_in_faked_t
     ASSERT_EQ(0, timer.elapsed());
 }
 
+TEST_F(QtFakeTimeTests, QElapsedTimer_copies_carry_faked_start_time)
+{
+    QElapsedTimer timer;
+
+    timer.start();
+
+    QtFakeTime::fastForward(1000);
+
+    QElapsedTimer copy = timer;
+
+    ASSERT_TRUE(copy.isValid());
+    ASSERT_NEAR(1000, copy.elapsed(), 10);
+
+    timer.invalidate();
+
+    ASSERT_FALSE(timer.isValid());
+    ASSERT_TRUE(copy.isValid());
+}
+
+TEST_F(QtFakeTimeTests, QElapsedTimer_nanosecond_resolution)
+{
+    QtFakeTime::set(QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate));
+    QtFakeTime::setFrozen(true);
+
+    QElapsedTimer timer;
+    QElapsedTimer later;
+
+    timer.start();
+
+    QtFakeTime::fastForward(std::chrono::microseconds(1500));
+
+    ASSERT_EQ(1500000, timer.nsecsElapsed());
+    ASSERT_EQ(1, timer.elapsed());
+
+    later.start();
+
+    QtFakeTime::fastForward(std::chrono::seconds(2));
+
+    QElapsedTimer last;
+
+    last.start();
+
+    ASSERT_EQ(1, timer.msecsTo(later));
+    ASSERT_EQ(-1, later.msecsTo(timer));
+    ASSERT_EQ(2, later.secsTo(last));
+    ASSERT_EQ(QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate).toMSecsSinceEpoch() + 1, later.msecsSinceReference());
+}
+
+TEST_F(QtFakeTimeTests, QTimer_precise_timer_scheduled_to_the_nanosecond)
+{
+    QtFakeTime::set(QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate));
+    QtFakeTime::setFrozen(true);
+
+    int preciseTimeoutCounter   = 0;
+    int coarseTimeoutCounter    = 0;
+
+    QTimer preciseTimer;
+    QTimer coarseTimer;
+
+    QObject::connect(&preciseTimer, &QTimer::timeout, [&](){++preciseTimeoutCounter;});
+    QObject::connect(&coarseTimer, &QTimer::timeout, [&](){++coarseTimeoutCounter;});
+
+    preciseTimer.setTimerType(Qt::PreciseTimer);
+    preciseTimer.setSingleShot(true);
+    coarseTimer.setSingleShot(true);
+
+    QtFakeTime::fastForward(std::chrono::microseconds(300));
+
+    preciseTimer.start(1);
+    coarseTimer.start(1);
+
+    // Precise timer due exactly 1mS after start, coarse timer on following whole mS
+    QtFakeTime::fastForward(std::chrono::microseconds(999));
+
+    ASSERT_EQ(0, preciseTimeoutCounter);
+    ASSERT_EQ(0, coarseTimeoutCounter);
+
+    QtFakeTime::fastForward(std::chrono::microseconds(1));
+
+    ASSERT_EQ(1, preciseTimeoutCounter);
+    ASSERT_EQ(0, coarseTimeoutCounter);
+
+    QtFakeTime::fastForward(std::chrono::microseconds(700));
+
+    ASSERT_EQ(1, coarseTimeoutCounter);
+}
+
+TEST_F(QtFakeTimeTests, QDeadlineTimer_honours_fast_forward_but_not_set)
+{
+    QtFakeTime::set(QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate));
+    QtFakeTime::setFrozen(true);
+
+    QDeadlineTimer deadline(1000);
+    QDeadlineTimer forever(QDeadlineTimer::Forever);
+
+    ASSERT_FALSE(deadline.hasExpired());
+    ASSERT_EQ(1000, deadline.remainingTime());
+
+    QtFakeTime::fastForward(std::chrono::microseconds(400500));
+
+    ASSERT_EQ(600, deadline.remainingTime());
+    ASSERT_EQ(599500000, deadline.remainingTimeNSecs());
+
+    // Jumps in faked date/time don't affect deadlines
+    QtFakeTime::set(QDateTime::fromString("2022-07-12T01:23:45", Qt::ISODate));
+
+    ASSERT_EQ(599500000, deadline.remainingTimeNSecs());
+
+    QtFakeTime::fastForward(600);
+
+    ASSERT_TRUE(deadline.hasExpired());
+    ASSERT_EQ(0, deadline.remainingTime());
+
+    ASSERT_FALSE(forever.hasExpired());
+    ASSERT_EQ(-1, forever.remainingTime());
+
+    // Deadlines continue on from faked time on return to real time
+    QDeadlineTimer later(10000);
+
+    QtFakeTime::setFrozen(false);
+    QtFakeTime::reset();
+
+    ASSERT_NEAR(10000, later.remainingTime(), 10);
+}
+
 TEST_F(QtFakeTimeTests, QTimer_behaves_normally_in_absense_of_fast_forward)
 {
     int timeoutCounter = 0;
@@ -283,6 +505,38 @@ TEST_F(QtFakeTimeTests, QTimer_behaves_normally_in_absense_of_fast_forward)
     ASSERT_EQ(3, timeoutCounter);
 }
 
+TEST_F(QtFakeTimeTests, QTimer_times_out_promptly_in_absense_of_fast_forward)
+{
+    int timeoutCounter = 0;
+
+    QTimer timer;
+
+    QObject::connect(&timer, &QTimer::timeout, [&](){++timeoutCounter;});
+
+    QtFakeTime::resetLatenessHistogram();
+
+    timer.start(55);
+
+    WaitWhileProcessingEvents(300);
+
+    timer.stop();
+
+    // Five due within the wait, allowing for the last to be missed on a loaded machine
+    ASSERT_GE(timeoutCounter, 4);
+    ASSERT_LE(timeoutCounter, 5);
+
+    // Timeouts generated from an idle timer armed for each timer's due time, rather than polled for, should mostly be well under 8mS
+    // late, and none anywhere near a whole interval late
+    std::array<uint64_t, QtFakeTime::latenessHistogramBuckets> histogram = QtFakeTime::latenessHistogram();
+
+    uint64_t prompt = histogram[0] + histogram[1] + histogram[2] + histogram[3];
+    uint64_t total  = std::accumulate(histogram.begin(), histogram.end(), uint64_t(0));
+
+    ASSERT_EQ(static_cast<uint64_t>(timeoutCounter), total);
+    ASSERT_GE(prompt + 1, total);
+    ASSERT_EQ(total, std::accumulate(histogram.begin(), histogram.begin() + 6, uint64_t(0)));
+}
+
 TEST_F(QtFakeTimeTests, QTimer_single_shot_timer_honours_fast_forward)
 {
     int timeoutCounter = 0;
@@ -395,6 +649,71 @@ TEST_F(QtFakeTimeTests, QTimer_repeating_timer_honours_fast_forward)
     ASSERT_EQ(3, timeoutCounter);
 }
 
+TEST_F(QtFakeTimeTests, frozen_time_only_moves_on_fast_forward)
+{
+    int timeoutCounter = 0;
+
+    QTimer timer;
+
+    QObject::connect(&timer, &QTimer::timeout, [&](){++timeoutCounter;});
+
+    QtFakeTime::set(QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate));
+    QtFakeTime::setFrozen(true);
+
+    qint64 frozenMSSinceEpoch = QDateTime::currentMSecsSinceEpoch();
+
+    timer.setSingleShot(true);
+    timer.start(50);
+
+    WaitRealTimeWhileProcessingEvents(100);
+
+    // Neither faked time nor timer has moved on with real time
+    ASSERT_EQ(frozenMSSinceEpoch, QDateTime::currentMSecsSinceEpoch());
+    ASSERT_EQ(0, timeoutCounter);
+
+    QtFakeTime::fastForward(50);
+
+    ASSERT_EQ(frozenMSSinceEpoch + 50, QDateTime::currentMSecsSinceEpoch());
+    ASSERT_EQ(1, timeoutCounter);
+
+    QtFakeTime::setFrozen(false);
+
+    WaitWhileProcessingEvents(100);
+
+    ASSERT_LT(frozenMSSinceEpoch + 50, QDateTime::currentMSecsSinceEpoch());
+}
+
+TEST_F(QtFakeTimeTests, dilated_time_runs_faster_than_real_time)
+{
+    int timeoutCounter = 0;
+
+    QTimer timer;
+
+    QObject::connect(&timer, &QTimer::timeout, [&](){++timeoutCounter;});
+
+    QtFakeTime::set(QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate));
+    QtFakeTime::setRate(50);
+
+    qint64 startMSSinceEpoch = QDateTime::currentMSecsSinceEpoch();
+
+    timer.start(1000);
+
+    WaitRealTimeWhileProcessingEvents(200);
+
+    timer.stop();
+
+    // 200mS real time is 10 seconds faked time, allow for slow hosts
+    qint64 fakedMSElapsed = QDateTime::currentMSecsSinceEpoch() - startMSSinceEpoch;
+
+    ASSERT_LE(5000, fakedMSElapsed);
+    ASSERT_EQ(fakedMSElapsed / 1000, timeoutCounter);
+
+    QtFakeTime::RateStats stats = QtFakeTime::rateStats();
+
+    ASSERT_EQ(50.0, stats.requestedRate);
+    ASSERT_LT(10.0, stats.achievedRate);
+}
+
 TEST_F(QtFakeTimeTests, QTimer_timerId_and_isActive_reflect_run_state)
 {
     int timeoutCounter = 0;
@@ -480,6 +799,746 @@ TEST_F(QtFakeTimeTests, interleaved_timers_trigger_appropriately)
 
 }
 
+TEST_F(QtFakeTimeTests, timers_due_at_same_time_trigger_in_order_started)
+{
+    std::vector<int> timeoutOrder;
+
+    QTimer timer1;
+    QTimer timer2;
+    QTimer timer3;
+
+    QObject::connect(&timer1, &QTimer::timeout, [&](){timeoutOrder.push_back(1);});
+    QObject::connect(&timer2, &QTimer::timeout, [&](){timeoutOrder.push_back(2);});
+    QObject::connect(&timer3, &QTimer::timeout, [&](){timeoutOrder.push_back(3);});
+
+    timer1.setSingleShot(true);
+    timer2.setSingleShot(true);
+    timer3.setSingleShot(true);
+
+    QtFakeTime::set(QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate));
+
+    timer3.start(1000);
+    timer1.start(1000);
+    timer2.start(1000);
+
+    // Restarting timer moves it behind others due at same time
+    timer3.start(1000);
+
+    QtFakeTime::fastForward(1000);
+
+    ASSERT_EQ((std::vector<int>{1, 2, 3}), timeoutOrder);
+}
+
+TEST_F(QtFakeTimeTests, batched_timeouts_process_events_once_all_timers_due_at_same_time_have_fired)
+{
+    std::vector<QString> events;
+
+    QTimer timer1;
+    QTimer timer2;
+
+    // Timer 1 defers additional work via. the event queue
+    QObject::connect(&timer1, &QTimer::timeout, [&](){events.push_back("timer1"); QTimer::singleShot(0, [&](){events.push_back("deferred");});});
+    QObject::connect(&timer2, &QTimer::timeout, [&](){events.push_back("timer2");});
+
+    timer1.setSingleShot(true);
+    timer2.setSingleShot(true);
+
+    QtFakeTime::set(QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate));
+
+    timer1.start(1000);
+    timer2.start(1000);
+
+    QtFakeTime::fastForward(1000);
+
+    ASSERT_EQ((std::vector<QString>{"timer1", "deferred", "timer2"}), events);
+
+    events.clear();
+
+    QtFakeTime::setBatchedTimeouts(true);
+
+    timer1.start(1000);
+    timer2.start(1000);
+
+    QtFakeTime::fastForward(1000);
+
+    ASSERT_EQ((std::vector<QString>{"timer1", "timer2", "deferred"}), events);
+}
+
+TEST_F(QtFakeTimeTests, skip_ahead_timer_generates_single_timeout_per_fast_forward)
+{
+    int timeoutCounter = 0;
+    int otherTimeoutCounter = 0;
+    uint64_t ticksSkipped = 0;
+
+    QTimer timer;
+    QTimer otherTimer;
+
+    QObject::connect(&timer, &QTimer::timeout, [&](){++timeoutCounter;});
+    QObject::connect(&otherTimer, &QTimer::timeout, [&](){++otherTimeoutCounter;});
+
+    QtFakeTime::setSkippedTicksHandler([&](QTimer* skipped, uint64_t ticks){if (skipped == &timer) ticksSkipped += ticks;});
+
+    QtFakeTime::setSkipAhead(&timer, true);
+
+    QtFakeTime::set(QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate));
+
+    timer.start(10);
+    otherTimer.start(1000);
+
+    // One hour
+    QtFakeTime::fastForward(3600000);
+
+    ASSERT_EQ(1, timeoutCounter);
+    ASSERT_EQ(359999u, ticksSkipped);
+    ASSERT_EQ(3600, otherTimeoutCounter);
+    ASSERT_EQ(10, timer.remainingTime());
+
+    // Single tick, nothing to skip
+    QtFakeTime::fastForward(10);
+
+    ASSERT_EQ(2, timeoutCounter);
+    ASSERT_EQ(359999u, ticksSkipped);
+
+    QtFakeTime::setSkipAhead(&timer, false);
+
+    QtFakeTime::fastForward(1000);
+
+    ASSERT_EQ(102, timeoutCounter);
+    ASSERT_EQ(3601, otherTimeoutCounter);
+
+    // Enable by objectName pattern
+    otherTimer.setObjectName("heartbeat_timer");
+    QtFakeTime::setSkipAhead("heartbeat*");
+
+    QtFakeTime::fastForward(3600000);
+
+    ASSERT_EQ(3602, otherTimeoutCounter);
+}
+
+TEST_F(QtFakeTimeTests, timing_wheel_timer_store_triggers_timers_appropriately)
+{
+    int timer1TimeoutCounter = 0;
+    int timer2TimeoutCounter = 0;
+
+    QTimer timer1;
+    QTimer timer2;
+
+    QObject::connect(&timer1, &QTimer::timeout, [&](){++timer1TimeoutCounter;});
+    QObject::connect(&timer2, &QTimer::timeout, [&](){++timer2TimeoutCounter;});
+
+    timer1.setSingleShot(false);
+    timer1.setInterval(1000);
+
+    timer2.setSingleShot(true);
+    timer2.setInterval(100000);
+
+    timer1.start();
+
+    // Active timer carried over to new store
+    QtFakeTime::setTimerStore(QtFakeTime::TimerStore::TimingWheel);
+
+    timer2.start();
+
+    QtFakeTime::fastForward(99990);
+
+    ASSERT_EQ(99, timer1TimeoutCounter);
+    ASSERT_EQ(0, timer2TimeoutCounter);
+    ASSERT_NEAR(10, timer2.remainingTime(), 1);
+
+    QtFakeTime::fastForward(20);
+
+    ASSERT_EQ(100, timer1TimeoutCounter);
+    ASSERT_EQ(1, timer2TimeoutCounter);
+
+    timer1.stop();
+
+    QtFakeTime::fastForward(1000);
+
+    ASSERT_EQ(100, timer1TimeoutCounter);
+}
+
+TEST_F(QtFakeTimeTests, faked_time_can_be_read_from_other_threads_during_fast_forward)
+{
+    QDateTime startTime = QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate);
+
+    QtFakeTime::set(startTime);
+
+    // Repeating timer, so that fast-forward steps through plenty of intermediate times
+    QTimer timer;
+
+    timer.start(10);
+
+    std::atomic<bool> fastForwardComplete(false);
+    std::atomic<bool> timeWentBackwards(false);
+
+    std::vector<std::thread> readers;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        readers.emplace_back([&](){
+                                    qint64 previousTime = startTime.toMSecsSinceEpoch();
+
+                                    while (!fastForwardComplete)
+                                    {
+                                        qint64 currentTime = QDateTime::currentMSecsSinceEpoch();
+
+                                        if (currentTime < previousTime)
+                                        {
+                                            timeWentBackwards = true;
+                                        }
+
+                                        previousTime = currentTime;
+                                    }
+                                });
+    }
+
+    QtFakeTime::fastForward(60000);
+
+    fastForwardComplete = true;
+
+    for (std::thread& reader : readers)
+    {
+        reader.join();
+    }
+
+    ASSERT_FALSE(timeWentBackwards);
+    ASSERT_GE(QDateTime::currentMSecsSinceEpoch(), startTime.addMSecs(60000).toMSecsSinceEpoch());
+}
+
+TEST_F(QtFakeTimeTests, timers_owned_by_other_threads_time_out_on_their_own_threads)
+{
+    QtFakeTime::set(QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate));
+
+    QThread workerThread;
+
+    workerThread.start();
+
+    std::atomic<int> mainTimeoutCounter(0);
+    std::atomic<int> workerTimeoutCounter(0);
+    std::atomic<bool> timeoutOnWrongThread(false);
+
+    QTimer mainTimer;
+
+    QObject::connect(&mainTimer, &QTimer::timeout, [&](){
+                                                            if (QThread::currentThread() != mainTimer.thread())
+                                                            {
+                                                                timeoutOnWrongThread = true;
+                                                            }
+
+                                                            ++mainTimeoutCounter;
+                                                        });
+
+    // Timer is created here but moved to worker thread before being started from there
+    QTimer* workerTimer = new QTimer();
+
+    workerTimer->moveToThread(&workerThread);
+
+    QObject::connect(workerTimer, &QTimer::timeout, [&](){
+                                                            if (QThread::currentThread() != &workerThread)
+                                                            {
+                                                                timeoutOnWrongThread = true;
+                                                            }
+
+                                                            ++workerTimeoutCounter;
+                                                        });
+
+    mainTimer.start(1000);
+    QMetaObject::invokeMethod(workerTimer, [=](){workerTimer->start(1000);}, Qt::BlockingQueuedConnection);
+
+    QtFakeTime::fastForward(10500);
+
+    ASSERT_EQ(10, mainTimeoutCounter);
+    ASSERT_EQ(10, workerTimeoutCounter);
+    ASSERT_FALSE(timeoutOnWrongThread);
+
+    QMetaObject::invokeMethod(workerTimer, [=](){delete workerTimer;}, Qt::BlockingQueuedConnection);
+
+    workerThread.quit();
+    workerThread.wait();
+}
+
+TEST_F(QtFakeTimeTests, QThread_sleep_fast_forwards_main_thread_and_parks_others)
+{
+    QtFakeTime::set(QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate));
+    QtFakeTime::setFrozen(true);
+
+    int timeoutCounter = 0;
+
+    QTimer timer;
+
+    QObject::connect(&timer, &QTimer::timeout, [&](){++timeoutCounter;});
+
+    timer.start(1000);
+
+    qint64 startMSSinceEpoch = QDateTime::currentMSecsSinceEpoch();
+
+    // Sleeping main thread moves faked time on, generating timeouts, without blocking
+    QThread::sleep(60);
+
+    ASSERT_EQ(60, timeoutCounter);
+    ASSERT_EQ(startMSSinceEpoch + 60000, QDateTime::currentMSecsSinceEpoch());
+
+    // Other threads remain asleep until faked time reaches their wake time
+    std::atomic<bool> workerStarted(false);
+    std::atomic<bool> workerAwake(false);
+
+    std::thread worker([&](){
+                                workerStarted = true;
+                                QThread::msleep(5000);
+                                workerAwake = true;
+                            });
+
+    while (!workerStarted)
+    {
+        QThread::yieldCurrentThread();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    QThread::msleep(4000);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    ASSERT_FALSE(workerAwake);
+
+    QThread::usleep(2000000);
+
+    worker.join();
+
+    ASSERT_TRUE(workerAwake);
+
+    timer.stop();
+}
+
+TEST_F(QtFakeTimeTests, timed_waits_time_out_on_auto_advanced_faked_time)
+{
+    QtFakeTime::set(QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate));
+    QtFakeTime::setFrozen(true);
+    QtFakeTime::setAutoAdvance(true);
+
+    std::chrono::steady_clock::time_point realStartTime = std::chrono::steady_clock::now();
+
+    qint64 startMSSinceEpoch = QDateTime::currentMSecsSinceEpoch();
+
+    // Lone blocked thread times out without delay, with faked time moved on to its deadline
+    QMutex mutex;
+    QWaitCondition condition;
+
+    mutex.lock();
+
+    ASSERT_FALSE(condition.wait(&mutex, 60000));
+
+    mutex.unlock();
+
+    ASSERT_EQ(startMSSinceEpoch + 60000, QDateTime::currentMSecsSinceEpoch());
+
+    QSemaphore semaphore;
+
+    ASSERT_FALSE(semaphore.tryAcquire(1, 30000));
+
+    ASSERT_EQ(startMSSinceEpoch + 90000, QDateTime::currentMSecsSinceEpoch());
+
+    // Faked time only moves on as far as the earliest of several blocked threads is due to wake
+    std::atomic<bool> workerStarted(false);
+
+    std::thread worker([&](){
+                                workerStarted = true;
+                                QThread::msleep(10000);
+                                semaphore.release();
+                            });
+
+    while (!workerStarted)
+    {
+        QThread::yieldCurrentThread();
+    }
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+    ASSERT_TRUE(semaphore.tryAcquire(1, 60000));
+
+    ASSERT_EQ(startMSSinceEpoch + 100000, QDateTime::currentMSecsSinceEpoch());
+
+    worker.join();
+
+    ASSERT_LT(std::chrono::steady_clock::now() - realStartTime, std::chrono::seconds(5));
+}
+
+TEST_F(QtFakeTimeTests, QProcess_waits_time_out_on_faked_time)
+{
+    QtFakeTime::set(QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate));
+    QtFakeTime::setFrozen(true);
+
+    std::chrono::steady_clock::time_point realStartTime = std::chrono::steady_clock::now();
+
+    QProcess process;
+
+    process.start("sleep", QStringList() << "60");
+
+    ASSERT_TRUE(process.waitForStarted());
+
+    qint64 startMSSinceEpoch = QDateTime::currentMSecsSinceEpoch();
+
+    QtFakeTime::setAutoAdvance(true);
+
+    // Wait on still running process times out on faked time
+    ASSERT_FALSE(process.waitForFinished(30000));
+
+    ASSERT_EQ(startMSSinceEpoch + 30000, QDateTime::currentMSecsSinceEpoch());
+    ASSERT_EQ(QProcess::Timedout, process.error());
+
+    // Wait on process that finishes early returns as soon as it does
+    QtFakeTime::setAutoAdvance(false);
+
+    process.kill();
+
+    ASSERT_TRUE(process.waitForFinished(30000));
+
+    ASSERT_EQ(startMSSinceEpoch + 30000, QDateTime::currentMSecsSinceEpoch());
+    ASSERT_LT(std::chrono::steady_clock::now() - realStartTime, std::chrono::seconds(5));
+}
+
+TEST_F(QtFakeTimeTests, libc_clocks_follow_faked_time_when_enabled)
+{
+    using namespace std::chrono;
+
+    QtFakeTime::set(QDateTime::fromString("2022-07-11T01:23:45Z", Qt::ISODate));
+    QtFakeTime::setFrozen(true);
+    QtFakeTime::setFakeLibcClocks(true, true);
+
+    qint64 msSinceEpoch = QDateTime::currentMSecsSinceEpoch();
+
+    struct timeval tv;
+
+    ASSERT_EQ(0, gettimeofday(&tv, nullptr));
+
+    ASSERT_EQ(msSinceEpoch, duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count());
+    ASSERT_EQ(msSinceEpoch / 1000, time(nullptr));
+    ASSERT_EQ(msSinceEpoch / 1000, tv.tv_sec);
+
+    steady_clock::time_point steadyStartTime = steady_clock::now();
+
+    QtFakeTime::fastForward(5000);
+
+    ASSERT_EQ(steadyStartTime + milliseconds(5000), steady_clock::now());
+    ASSERT_EQ(msSinceEpoch + 5000, duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count());
+
+    // Back to real time once disabled
+    QtFakeTime::setFakeLibcClocks(false, false);
+
+    ASSERT_GT(duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count(), msSinceEpoch + 5000);
+}
+
+TEST_F(QtFakeTimeTests, libc_sleeps_and_waits_run_on_faked_time_when_enabled)
+{
+    QtFakeTime::set(QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate));
+    QtFakeTime::setFrozen(true);
+    QtFakeTime::setFakeLibcClocks(true, true);
+    QtFakeTime::setFakeLibcWaits(true);
+
+    qint64 startMSSinceEpoch = QDateTime::currentMSecsSinceEpoch();
+
+    // Sleeps on main thread fast-forward faked time
+    std::this_thread::sleep_for(std::chrono::seconds(60));
+
+    ASSERT_EQ(startMSSinceEpoch + 60000, QDateTime::currentMSecsSinceEpoch());
+
+    ASSERT_EQ(0, poll(nullptr, 0, 5000));
+
+    ASSERT_EQ(startMSSinceEpoch + 65000, QDateTime::currentMSecsSinceEpoch());
+
+    // Timed waits on other threads time out on auto-advanced faked time.  Enabling auto-advance forgets main thread's waits above (and
+    // any made by earlier tests), so main thread blocked joining the waiter doesn't hold time back.
+    QtFakeTime::setAutoAdvance(true);
+
+    std::mutex mutex;
+    std::condition_variable condition;
+    std::cv_status status = std::cv_status::no_timeout;
+
+    std::thread waiter([&]()
+                       {
+                           std::unique_lock<std::mutex> lock(mutex);
+
+                           status = condition.wait_for(lock, std::chrono::seconds(30));
+                       });
+
+    waiter.join();
+
+    ASSERT_EQ(std::cv_status::timeout, status);
+    ASSERT_EQ(startMSSinceEpoch + 95000, QDateTime::currentMSecsSinceEpoch());
+}
+
+TEST_F(QtFakeTimeTests, trace_records_fast_forward_and_timeouts_on_faked_and_real_timelines)
+{
+    QtFakeTime::setFrozen(true);
+    QtFakeTime::set(QDateTime::fromString("2022-01-01T00:00:00Z", Qt::ISODate));
+
+    QTimer fastTimer;
+    QTimer slowTimer;
+
+    fastTimer.setObjectName("fast");
+    slowTimer.setObjectName("slow");
+
+    fastTimer.start(100);
+    slowTimer.start(250);
+
+    auto readTrace = [](std::map<QString, std::vector<double>>& fakedTimes, int& realEvents)
+    {
+        QString fileName = QDir::temp().filePath("QtFakeTime_trace.json");
+
+        ASSERT_TRUE(QtFakeTime::writeChromeTrace(fileName));
+
+        QFile file(fileName);
+
+        ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+
+        QJsonDocument trace = QJsonDocument::fromJson(file.readAll());
+
+        file.remove();
+
+        ASSERT_TRUE(trace.isObject());
+
+        for (const QJsonValue& value : trace.object()["traceEvents"].toArray())
+        {
+            QJsonObject event = value.toObject();
+
+            if (event["ph"].toString() == "M")
+            {
+                continue;
+            }
+
+            if (event["pid"].toInt() == 0)
+            {
+                ++realEvents;
+            }
+            else
+            {
+                fakedTimes[event["name"].toString()].push_back(event["ts"].toDouble());
+            }
+        }
+    };
+
+    // Faked timeline runs from start of fast-forward (in uS), with every timeout recorded on real timeline too.  Nothing recorded once
+    // stopped.
+    QtFakeTime::startTrace();
+    QtFakeTime::fastForward(1000);
+    QtFakeTime::stopTrace();
+
+    QtFakeTime::fastForward(1000);
+
+    std::map<QString, std::vector<double>> fakedTimes;
+    int realEvents = 0;
+
+    readTrace(fakedTimes, realEvents);
+
+    ASSERT_EQ(fakedTimes.size(), 3u);
+    ASSERT_EQ(fakedTimes["fast"], (std::vector<double>{100000, 200000, 300000, 400000, 500000, 600000, 700000, 800000, 900000, 1000000}));
+    ASSERT_EQ(fakedTimes["slow"], (std::vector<double>{250000, 500000, 750000, 1000000}));
+    ASSERT_EQ(fakedTimes["fastForward"], (std::vector<double>{0}));
+    ASSERT_EQ(realEvents, 15);
+
+    // Ring buffer only keeps most recent records
+    QtFakeTime::startTrace(4);
+    QtFakeTime::fastForward(1000);
+    QtFakeTime::stopTrace();
+
+    fakedTimes.clear();
+    realEvents = 0;
+
+    readTrace(fakedTimes, realEvents);
+
+    ASSERT_EQ(fakedTimes["fastForward"].size(), 1u);
+    ASSERT_EQ(fakedTimes["fast"].size() + fakedTimes["slow"].size(), 3u);
+    ASSERT_EQ(realEvents, 4);
+}
+
+TEST_F(QtFakeTimeTests, stats_count_timeouts_active_timers_clock_reads_and_time_fast_forwarded)
+{
+    QtFakeTime::setFrozen(true);
+    QtFakeTime::set(QDateTime::fromString("2022-01-01T00:00:00Z", Qt::ISODate));
+
+    QtFakeTime::resetStats();
+
+    QtFakeTime::Stats before = QtFakeTime::stats();
+
+    ASSERT_EQ(before.timeouts, 0u);
+    ASSERT_EQ(before.peakActiveTimers, before.activeTimers);
+
+    {
+        QTimer fastTimer;
+        QTimer slowTimer;
+
+        fastTimer.start(100);
+        slowTimer.start(1000);
+
+        QtFakeTime::fastForward(1000);
+
+        QElapsedTimer elapsedTimer;
+        elapsedTimer.start();
+
+        QDateTime::currentMSecsSinceEpoch();
+
+        QtFakeTime::Stats after = QtFakeTime::stats();
+
+        ASSERT_EQ(after.timeouts, 11u);
+        ASSERT_GE(after.eventPumps, 1u);
+        ASSERT_EQ(after.activeTimers, before.activeTimers + 2);
+        ASSERT_EQ(after.peakActiveTimers, after.activeTimers);
+        ASSERT_GE(after.elapsedTimerStarts, 1u);
+        ASSERT_GE(after.clockReads, 2u);
+        ASSERT_EQ(after.fastForwardedMS, 1000u);
+        ASSERT_GT(after.fastForwardRealNS, 0u);
+    }
+
+    // Destroyed timers no longer active, peak remains
+    QtFakeTime::Stats after = QtFakeTime::stats();
+
+    ASSERT_EQ(after.activeTimers, before.activeTimers);
+    ASSERT_EQ(after.peakActiveTimers, before.activeTimers + 2);
+}
+
+TEST_F(QtFakeTimeTests, stats_leave_out_faked_time_proceeding_in_lockstep_with_real_time)
+{
+    QtFakeTime::set(QDateTime::fromString("2022-01-01T00:00:00Z", Qt::ISODate));
+
+    qint64 startMSSinceEpoch = QDateTime::currentMSecsSinceEpoch();
+
+    QtFakeTime::resetStats();
+
+    WaitWhileProcessingEvents(100);
+
+    ASSERT_GE(QDateTime::currentMSecsSinceEpoch(), startMSSinceEpoch + 100);
+
+    QtFakeTime::Stats stats = QtFakeTime::stats();
+
+    ASSERT_EQ(stats.fastForwardedMS, 0u);
+    ASSERT_EQ(stats.fastForwardRealNS, 0u);
+}
+
+TEST_F(QtFakeTimeTests, advanceToNextTimer_steps_exactly_to_each_timer_due)
+{
+    QtFakeTime::setFrozen(true);
+    QtFakeTime::set(QDateTime::fromString("2022-01-01T00:00:00Z", Qt::ISODate));
+
+    qint64 startMSSinceEpoch = QDateTime::currentMSecsSinceEpoch();
+
+    QTimer firstTimer;
+    QTimer secondTimer;
+    int firstTimeouts = 0;
+    int secondTimeouts = 0;
+
+    firstTimer.setSingleShot(true);
+    secondTimer.setSingleShot(true);
+
+    QObject::connect(&firstTimer, &QTimer::timeout, [&](){++firstTimeouts;});
+    QObject::connect(&secondTimer, &QTimer::timeout, [&](){++secondTimeouts;});
+
+    firstTimer.start(300);
+    secondTimer.start(1000);
+
+    ASSERT_TRUE(QtFakeTime::advanceToNextTimer());
+    ASSERT_EQ(startMSSinceEpoch + 300, QDateTime::currentMSecsSinceEpoch());
+    ASSERT_EQ(1, firstTimeouts);
+    ASSERT_EQ(0, secondTimeouts);
+
+    ASSERT_TRUE(QtFakeTime::advanceToNextTimer());
+    ASSERT_EQ(startMSSinceEpoch + 1000, QDateTime::currentMSecsSinceEpoch());
+    ASSERT_EQ(1, firstTimeouts);
+    ASSERT_EQ(1, secondTimeouts);
+
+    // No timers left active, time left alone
+    ASSERT_FALSE(QtFakeTime::advanceToNextTimer());
+    ASSERT_EQ(startMSSinceEpoch + 1000, QDateTime::currentMSecsSinceEpoch());
+}
+
+TEST_F(QtFakeTimeTests, fastForwardUntil_stops_once_predicate_holds_after_timeout)
+{
+    QtFakeTime::setFrozen(true);
+    QtFakeTime::set(QDateTime::fromString("2022-01-01T00:00:00Z", Qt::ISODate));
+
+    qint64 startMSSinceEpoch = QDateTime::currentMSecsSinceEpoch();
+
+    QTimer timer;
+    int timeouts = 0;
+
+    QObject::connect(&timer, &QTimer::timeout, [&](){++timeouts;});
+
+    timer.start(100);
+
+    // Stops on the timeout at which predicate first holds, rather than overshooting
+    ASSERT_EQ(500u, QtFakeTime::fastForwardUntil([&](){return timeouts == 5;}, 10000));
+    ASSERT_EQ(startMSSinceEpoch + 500, QDateTime::currentMSecsSinceEpoch());
+    ASSERT_EQ(5, timeouts);
+
+    // Already holds, so time doesn't move at all
+    ASSERT_EQ(0u, QtFakeTime::fastForwardUntil([&](){return timeouts == 5;}, 10000));
+    ASSERT_EQ(startMSSinceEpoch + 500, QDateTime::currentMSecsSinceEpoch());
+
+    // Never holds, so runs to limit
+    ASSERT_EQ(std::chrono::milliseconds(250), QtFakeTime::fastForwardUntil([&](){return false;}, std::chrono::milliseconds(250)));
+    ASSERT_EQ(startMSSinceEpoch + 750, QDateTime::currentMSecsSinceEpoch());
+    ASSERT_EQ(7, timeouts);
+}
+
+TEST_F(QtFakeTimeTests, threads_bound_to_separate_time_domains_have_independent_clocks)
+{
+    QDateTime startTime = QDateTime::fromString("2022-07-11T01:23:45", Qt::ISODate);
+
+    QtFakeTime::set(startTime);
+
+    QtFakeTime::TimeDomain* domain = QtFakeTime::createTimeDomain();
+
+    QThread domainThread;
+
+    QtFakeTime::bindTimeDomain(&domainThread, domain);
+
+    domainThread.start();
+
+    QtFakeTime::set(domain, startTime.addDays(1));
+
+    int mainTimeoutCounter = 0;
+    std::atomic<int> domainTimeoutCounter(0);
+
+    QTimer mainTimer;
+
+    QObject::connect(&mainTimer, &QTimer::timeout, [&](){++mainTimeoutCounter;});
+
+    QTimer* domainTimer = new QTimer();
+
+    domainTimer->moveToThread(&domainThread);
+
+    QObject::connect(domainTimer, &QTimer::timeout, [&](){++domainTimeoutCounter;});
+
+    qint64 domainThreadTime = 0;
+
+    mainTimer.start(1000);
+    QMetaObject::invokeMethod(domainTimer, [&](){
+                                                    domainThreadTime = QDateTime::currentMSecsSinceEpoch();
+                                                    domainTimer->start(1000);
+                                                },
+                              Qt::BlockingQueuedConnection);
+
+    ASSERT_EQ(startTime.addDays(1).toMSecsSinceEpoch(), domainThreadTime);
+    ASSERT_EQ(startTime.toMSecsSinceEpoch(), QDateTime::currentMSecsSinceEpoch());
+
+    // Fast-forwarding domain leaves default domain's clock & timers alone
+    QtFakeTime::fastForward(domain, 5500);
+
+    ASSERT_EQ(5, domainTimeoutCounter);
+    ASSERT_EQ(0, mainTimeoutCounter);
+    ASSERT_NEAR(startTime.toMSecsSinceEpoch(), QDateTime::currentMSecsSinceEpoch(), 100);
+
+    // ...and vice versa
+    QtFakeTime::fastForward(2500);
+
+    ASSERT_EQ(5, domainTimeoutCounter);
+    ASSERT_EQ(2, mainTimeoutCounter);
+
+    QMetaObject::invokeMethod(domainTimer, [=](){delete domainTimer;}, Qt::BlockingQueuedConnection);
+
+    domainThread.quit();
+    domainThread.wait();
+}
+
 TEST_F(QtFakeTimeTests, QTimer_single_shot_timer_scheduled_via_static_method_honours_fast_forward)
 {
     int timeoutCounter = 0;